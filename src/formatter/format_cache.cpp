@@ -0,0 +1,186 @@
+#include "format_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#define utime _utime
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+namespace formatter {
+    static const char entryMagic[4] = {'H', 'F', 'M', 'C'};
+    // 格式化输出有任何变化时递增，使旧版本记录的条目全部失效
+    static const uint32_t formatVersion = 3;
+    static const size_t shardCount = 256;
+
+    struct CacheRecord {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint64_t outputHash;
+        uint32_t unchanged;
+        uint32_t reserved;
+    };
+
+    static inline uint64_t mix(uint64_t h, uint64_t w) {
+        h ^= w;
+        h *= 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    bool hashContent(const std::string& filename, uint64_t& hash, uint64_t& size) {
+        FILE* file = fopen(filename.c_str(), "rb");
+        if (!file) return false;
+        uint64_t h = 0x84222325CBF29CE4ULL;
+        uint64_t total = 0;
+        std::vector<unsigned char> buf(1 << 16); // 8的倍数，分块不影响结果
+        size_t n;
+        while ((n = fread(buf.data(), 1, buf.size(), file)) > 0) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                uint64_t w;
+                memcpy(&w, buf.data() + i, 8);
+                h = mix(h, w);
+            }
+            if (i < n) {
+                uint64_t w = 0;
+                memcpy(&w, buf.data() + i, n - i);
+                h = mix(h, w);
+            }
+            total += n;
+        }
+        fclose(file);
+        hash = mix(h, total);
+        size = total;
+        return true;
+    }
+
+    static void makeDir(const std::string& path) {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    FormatCache::FormatCache(std::string dir, size_t maxEntries)
+        : dir(std::move(dir)), perShard(std::max<size_t>((maxEntries + shardCount - 1) / shardCount, 1)) {}
+
+    uint64_t FormatCache::key(uint64_t inputHash, uint64_t inputSize, int width, unsigned flags) {
+        uint64_t k = mix(inputHash, inputSize);
+        k = mix(k, formatVersion);
+        return mix(k, static_cast<uint64_t>(flags) << 32 | static_cast<uint32_t>(width));
+    }
+
+    std::string FormatCache::shardDir(uint64_t key) const {
+        char name[4];
+        snprintf(name, sizeof(name), "%02x", static_cast<unsigned>(key >> 56));
+        return dir + "/" + name;
+    }
+
+    std::string FormatCache::entryPath(uint64_t key) const {
+        char name[20];
+        snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return shardDir(key) + "/" + name;
+    }
+
+    bool FormatCache::lookup(uint64_t key, FormatCacheEntry& entry) const {
+        std::string path = entryPath(key);
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+        CacheRecord rec{};
+        bool ok = fread(&rec, sizeof(rec), 1, file) == 1;
+        fclose(file);
+        if (!ok || memcmp(rec.magic, entryMagic, sizeof(entryMagic)) != 0 || rec.version != formatVersion ||
+            rec.key != key) {
+            return false;
+        }
+        entry.unchanged = rec.unchanged != 0;
+        entry.outputHash = rec.outputHash;
+        utime(path.c_str(), nullptr); // 记录最近一次命中，淘汰时据此排序
+        return true;
+    }
+
+    bool FormatCache::store(uint64_t key, const FormatCacheEntry& entry) const {
+        std::string shard = shardDir(key);
+        makeDir(dir);
+        makeDir(shard);
+        CacheRecord rec{};
+        memcpy(rec.magic, entryMagic, sizeof(entryMagic));
+        rec.version = formatVersion;
+        rec.key = key;
+        rec.outputHash = entry.outputHash;
+        rec.unchanged = entry.unchanged ? 1 : 0;
+
+        // 临时文件名带进程号，并发写同一条目时各写各的，重命名后以最后一个为准
+        std::string path = entryPath(key);
+        std::string tmp = path + "." + std::to_string(getpid()) + ".tmp";
+        FILE* out = fopen(tmp.c_str(), "wb");
+        if (!out) return false;
+        bool ok = fwrite(&rec, sizeof(rec), 1, out) == 1;
+        ok = fclose(out) == 0 && ok;
+#ifdef _WIN32
+        std::remove(path.c_str()); // Windows下rename不覆盖已有文件
+#endif
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        if (bumpCount(shard) > perShard) evict(shard);
+        return true;
+    }
+
+    // 计数文件不加锁，并发写入时可能少计，淘汰时按实际条目数重写；读不到时从0开始
+    size_t FormatCache::bumpCount(const std::string& shard) const {
+        uint32_t count = 0;
+        std::string path = shard + "/.count";
+        if (FILE* in = fopen(path.c_str(), "rb")) {
+            if (fread(&count, sizeof(count), 1, in) != 1) count = 0;
+            fclose(in);
+        }
+        writeCount(shard, ++count);
+        return count;
+    }
+
+    void FormatCache::writeCount(const std::string& shard, uint32_t count) const {
+        std::string path = shard + "/.count";
+        if (FILE* out = fopen(path.c_str(), "wb")) {
+            fwrite(&count, sizeof(count), 1, out);
+            fclose(out);
+        }
+    }
+
+    // 按最近使用时间删除最旧的条目，直到比份额少八分之一；并发删除同一文件时失败的一方忽略即可
+    void FormatCache::evict(const std::string& shard) const {
+#ifndef _WIN32
+        DIR* d = opendir(shard.c_str());
+        if (!d) return;
+        std::vector<std::pair<time_t, std::string>> entries;
+        while (dirent* e = readdir(d)) {
+            // 只统计条目文件，跳过 . 、..、计数文件和临时文件
+            if (strchr(e->d_name, '.')) continue;
+            std::string path = shard + "/" + e->d_name;
+            struct stat st{};
+            if (stat(path.c_str(), &st) == 0) entries.emplace_back(st.st_mtime, std::move(path));
+        }
+        closedir(d);
+        size_t keep = perShard - perShard / 8;
+        size_t excess = entries.size() > keep ? entries.size() - keep : 0;
+        std::partial_sort(entries.begin(), entries.begin() + excess, entries.end());
+        for (size_t i = 0; i < excess; ++i) std::remove(entries[i].second.c_str());
+        writeCount(shard, static_cast<uint32_t>(entries.size() - excess));
+#else
+        (void)shard; // Windows下不做淘汰
+#endif
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef FORMAT_CACHE_H
+#define FORMAT_CACHE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace formatter {
+    // 一个输入文件的格式化结果
+    struct FormatCacheEntry {
+        bool unchanged;      // 格式化输出与输入完全相同
+        uint64_t outputHash; // 输出内容的哈希，0表示未知（如--check发现不同后提前结束）
+    };
+
+    // 格式化结果的持久缓存：以输入内容哈希、格式化器版本和影响输出的选项为键
+    // - 每个条目一个小文件，位于 目录/键的前两位十六进制/键；先写临时文件再重命名，多个进程并发读写安全
+    // - 条目总数有上限：按键的前两位分为256组，每组的条目数记在组目录下的.count中，写入时加一；
+    //   只在计数超出份额时扫描该组，删除最久未命中的条目，留出八分之一的余量，扫描的开销分摊到多次写入
+    class FormatCache {
+    public:
+        explicit FormatCache(std::string dir, size_t maxEntries = 1 << 16);
+        // 影响输出的开关，按位组合进键；StyleShift起的各位是风格编号（StyleId）
+        enum Flags : unsigned { KeepTrivia = 1, StyleShift = 8 };
+        static uint64_t key(uint64_t inputHash, uint64_t inputSize, int width, unsigned flags = 0);
+        bool lookup(uint64_t key, FormatCacheEntry& entry) const; // 命中时刷新条目的使用时间
+        bool store(uint64_t key, const FormatCacheEntry& entry) const;
+
+    private:
+        std::string dir;
+        size_t perShard; // 每组最多保留的条目数
+        std::string shardDir(uint64_t key) const;
+        std::string entryPath(uint64_t key) const;
+        size_t bumpCount(const std::string& shard) const; // 组内计数加一，返回新的计数
+        void writeCount(const std::string& shard, uint32_t count) const;
+        void evict(const std::string& shard) const;
+    };
+
+    // 计算文件内容的哈希，按8字节一组混合，比逐字节的FNV-1a快；同时给出文件大小
+    bool hashContent(const std::string& filename, uint64_t& hash, uint64_t& size);
+}
+
+#endif //FORMAT_CACHE_H
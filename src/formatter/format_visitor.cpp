@@ -0,0 +1,407 @@
+#include "format_visitor.h"
+#include <cctype>
+#include <string>
+#include <unordered_map>
+
+namespace formatter {
+    using NT = parser::NodeType;
+
+    static const std::unordered_map<std::string, std::string> operatorReplacements = {
+        {"PLUS", "+"},
+        {"MINUS", "-"},
+        {"MUL", "*"},
+        {"DIV", "/"},
+        {"MOD", "%"},
+        {"EQ", "=="},
+        {"NEQ", "!="},
+        {"LT", "<"},
+        {"GT", ">"},
+        {"LE", "<="},
+        {"GE", ">="},
+        {"NOT", "!"}
+    };
+
+    // 两个字符直接相连时会被词法分析合成一个Token或构成注释的开头；
+    // 本语言没有 ++ 和 --，但压缩结果要交给C编译器，a - -b 仍须分开
+    static bool joins(char a, char b) {
+        auto word = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+        if (word(a) && word(b)) return true;
+        if (b == '=') return a == '=' || a == '!' || a == '<' || a == '>';
+        if (a == '/') return b == '/' || b == '*';
+        return (a == '&' || a == '|' || a == '+' || a == '-') && b == a;
+    }
+
+    // 去掉片段两端的空格，与已写出的内容相连会改变Token划分时才补一个空格
+    template <class Style>
+    void FormatVisitor<Style>::minifyText(const char* s, size_t n) {
+        while (n && *s == ' ') {
+            ++s;
+            --n;
+        }
+        while (n && s[n - 1] == ' ') --n;
+        if (!n) return;
+        if (joins(last, *s)) out.put(' ');
+        out.write(s, n);
+        last = s[n - 1];
+    }
+
+    template <class Style>
+    void FormatVisitor<Style>::printIndent() {
+        if (Style::minify) return;
+        if (layout) {
+            layout->startLine(indent);
+        } else {
+            Style::indent(out, indent);
+        }
+    }
+
+    template <class Style>
+    void FormatVisitor<Style>::parenthesized(parser::ASTNode* node) {
+        // 无参数的函数是空ParamList节点，无实参的调用没有实参列表节点
+        if (!node || (node->type == NT::ParamList && node->children.empty())) {
+            text("()");
+            return;
+        }
+        text(Style::openParen());
+        traverse(node);
+        text(Style::closeParen());
+    }
+
+    template <class Style>
+    const char* FormatVisitor<Style>::op(parser::ASTNode* node) {
+        return op(node->token);
+    }
+
+    template <class Style>
+    const char* FormatVisitor<Style>::op(const std::string& name) {
+        return operatorReplacements.at(name).c_str();
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::chain(parser::ASTNode* node, const char* fixedOp) {
+        const std::string& ops = node->token;
+        size_t from = 0;
+        open();
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            if (i > 0) {
+                if (fixedOp) {
+                    text(" ");
+                    text(fixedOp);
+                    softBreak();
+                } else {
+                    // 取token中的下一个运算符名
+                    size_t end = ops.find(' ', from);
+                    if (end == std::string::npos) end = ops.size();
+                    text(" ");
+                    text(op(ops.substr(from, end - from)));
+                    softBreak();
+                    from = end + 1;
+                }
+            }
+            traverse(node->children[i]);
+        }
+        close();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::commaList(parser::ASTNode* node) {
+        open();
+        commaItems(node);
+        close();
+        return true;
+    }
+
+    // 参数列表的尾部是嵌套的同类节点，与外层合为同一组
+    template <class Style>
+    void FormatVisitor<Style>::commaItems(parser::ASTNode* node) {
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            auto* child = node->children[i];
+            if (child->type == node->type) {
+                commaItems(child);
+            } else {
+                traverse(child);
+            }
+            if (i + 1 < node->children.size()) {
+                text(",");
+                softBreak();
+            }
+        }
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::terminal(parser::ASTNode* node) {
+        text(node->token);
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::comment(parser::ASTNode* node) {
+        if (Style::minify) return true; // 压缩输出不保留注释
+        printIndent();
+        text(node->token);
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::exprOnly(parser::ASTNode* node) {
+        if (node && node->type == NT::ExprStmt) {
+            if (!node->children.empty()) traverse(node->children[0]);
+            return true;
+        }
+        return traverse(node);
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitFunctionDecl(parser::ASTNode* node) {
+        printIndent();
+        traverse(node->children[0]); // type
+        text(" ");
+        traverse(node->children[1]); // ident
+        // 参数列表输出
+        parenthesized(node->children.size() > 2 ? node->children[2] : nullptr);
+        text(";");
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::functionHead(parser::ASTNode* node) {
+        printIndent();
+        traverse(node->children[0]); // type
+        text(" ");
+        traverse(node->children[1]); // ident
+        // 参数列表输出
+        parenthesized(node->children.size() > 2 ? node->children[2] : nullptr);
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitFunctionDef(parser::ASTNode* node) {
+        functionHead(node);
+        // 复合语句体
+        if (node->children.size() > 3) traverse(node->children[3]);
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitParam(parser::ASTNode* node) {
+        traverse(node->children[0]); // type
+        text(" ");
+        traverse(node->children[1]); // ident
+        // 无论有无第三个子节点，只要是数组类型都输出
+        for (size_t i = 2; i < node->children.size(); ++i) {
+            if (node->children[i] && node->children[i]->type == NT::ArrayType) {
+                traverse(node->children[i]); // arrayType
+            }
+        }
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitArrayType(parser::ASTNode* node) {
+        // 省略长度的数组参数（如 int b[]）没有维度子节点
+        if (node->children.empty()) text("[]");
+        for (auto* dim : node->children) {
+            text("[");
+            traverse(dim);
+            text("]");
+        }
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitVarDecl(parser::ASTNode* node) {
+        printIndent();
+        traverse(node->children[0]); // type
+        text(" ");
+        traverse(node->children[1]); // ident
+        // 数组类型
+        size_t idx = 2;
+        if (node->children.size() > idx && node->children[idx]->type == NT::ArrayType) {
+            traverse(node->children[idx]);
+            ++idx;
+        }
+        // 赋值
+        if (node->children.size() > idx) {
+            open();
+            text(" =");
+            softBreak();
+            traverse(node->children[idx]);
+            close();
+        }
+        text(";");
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitCompoundStmt(parser::ASTNode* node) {
+        printIndent();
+        text("{");
+        newline();
+        blockContents(node);
+        return true;
+    }
+
+    // 块内语句和右大括号；chained时右大括号后不换行，由调用者接着输出（如K&R风格的 } else）
+    template <class Style>
+    void FormatVisitor<Style>::blockContents(parser::ASTNode* block, bool chained) {
+        ++indent;
+        // 局部变量定义与语句列表
+        for (auto* child : block->children) traverse(child);
+        --indent;
+        printIndent();
+        text("}");
+        if (!chained) newline();
+    }
+
+    // 控制语句的语句体：K&R风格下复合语句的左大括号接在语句头之后，其余情况另起一行
+    template <class Style>
+    void FormatVisitor<Style>::body(parser::ASTNode* stmt) {
+        if (!Style::allman && stmt && stmt->type == NT::CompoundStmt) {
+            text(" {");
+            newline();
+            blockContents(stmt);
+        } else {
+            newline();
+            traverse(stmt);
+        }
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitExprStmt(parser::ASTNode* node) {
+        printIndent();
+        if (!node->children.empty()) traverse(node->children[0]);
+        text(";");
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitIfStmt(parser::ASTNode* node) {
+        ifStmt(node, true);
+        return true;
+    }
+
+    // indentFirst为false时接在当前行之后输出（K&R风格的 else if）
+    template <class Style>
+    void FormatVisitor<Style>::ifStmt(parser::ASTNode* node, bool indentFirst) {
+        if (indentFirst) printIndent();
+        text("if ");
+        parenthesized(node->children[0]);
+        parser::ASTNode* then = node->children[1];
+        parser::ASTNode* other = node->children.size() == 3 ? node->children[2] : nullptr;
+        if (!Style::allman && other && then && then->type == NT::CompoundStmt) {
+            text(" {");
+            newline();
+            blockContents(then, true);
+            text(" else");
+        } else {
+            body(then);
+            if (!other) return;
+            printIndent();
+            text("else");
+        }
+        if (!Style::allman && other->type == NT::IfStmt) {
+            text(" ");
+            ifStmt(other, false);
+        } else {
+            body(other);
+        }
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitWhileStmt(parser::ASTNode* node) {
+        printIndent();
+        text("while ");
+        parenthesized(node->children[0]);
+        body(node->children[1]);
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitForStmt(parser::ASTNode* node) {
+        printIndent();
+        text("for ");
+        text(Style::openParen());
+        open();
+        exprOnly(node->children[0]); text(";"); softBreak();
+        exprOnly(node->children[1]); text(";"); softBreak();
+        exprOnly(node->children[2]);
+        close();
+        text(Style::closeParen());
+        body(node->children[3]);
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitReturnStmt(parser::ASTNode* node) {
+        printIndent();
+        text("return");
+        if (!node->children.empty()) {
+            text(" ");
+            traverse(node->children[0]);
+        }
+        text(";");
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitBreakStmt(parser::ASTNode*) {
+        printIndent();
+        text("break;");
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitContinueStmt(parser::ASTNode*) {
+        printIndent();
+        text("continue;");
+        newline();
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitUnaryExpr(parser::ASTNode* node) {
+        text(op(node));
+        traverse(node->children[0]);
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitPostfixExpr(parser::ASTNode* node) {
+        traverse(node->children[0]); // ident
+        parenthesized(node->children.size() > 1 ? node->children[1] : nullptr);
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitArrayAccess(parser::ASTNode* node) {
+        traverse(node->children[0]);
+        text("[");
+        traverse(node->children[1]);
+        text("]");
+        return true;
+    }
+
+    template <class Style>
+    bool FormatVisitor<Style>::visitParenthesizedExpr(parser::ASTNode* node) {
+        if (node->children.empty()) {
+            text("()");
+            return true;
+        }
+        text(Style::openParen());
+        traverse(node->children[0]);
+        text(Style::closeParen());
+        return true;
+    }
+
+#define FORMATTER_INSTANTIATE_VISITOR(S, name) template class FormatVisitor<S>;
+    FORMATTER_STYLES(FORMATTER_INSTANTIATE_VISITOR)
+#undef FORMATTER_INSTANTIATE_VISITOR
+}
@@ -0,0 +1,113 @@
+#ifndef FORMAT_VISITOR_H
+#define FORMAT_VISITOR_H
+#include <cstring>
+#include <memory>
+#include <string>
+#include "ast_visitor.h"
+#include "buffered_writer.h"
+#include "layout.h"
+#include "style.h"
+
+namespace formatter {
+    // 把AST格式化输出为C代码的遍历器，缩进、大括号位置和括号内空格由风格策略Style决定（见style.h）
+    // width大于0时每行先交给Layout，超过该列宽的行在运算符、逗号和初始化的 '=' 之后折行
+    template <class Style>
+    class FormatVisitor : public parser::ASTVisitor<FormatVisitor<Style>> {
+    public:
+        using parser::ASTVisitor<FormatVisitor<Style>>::traverse;
+
+        explicit FormatVisitor(parser::BufferedWriter& out, int indent = 0, int width = 0)
+            : out(out), indent(indent), layout(width > 0 && !Style::minify ? new Layout<Style>(out, width) : nullptr) {}
+
+        bool visitFunctionDecl(parser::ASTNode* node);
+        bool visitFunctionDef(parser::ASTNode* node);
+        bool visitParamList(parser::ASTNode* node) { return commaList(node); }
+        bool visitParam(parser::ASTNode* node);
+        bool visitArrayType(parser::ASTNode* node);
+        bool visitVarDecl(parser::ASTNode* node);
+        bool visitLocalVarDecl(parser::ASTNode* node) { return visitVarDecl(node); }
+        bool visitCompoundStmt(parser::ASTNode* node);
+
+        bool visitExprStmt(parser::ASTNode* node);
+        bool visitIfStmt(parser::ASTNode* node);
+        bool visitWhileStmt(parser::ASTNode* node);
+        bool visitForStmt(parser::ASTNode* node);
+        bool visitReturnStmt(parser::ASTNode* node);
+        bool visitBreakStmt(parser::ASTNode* node);
+        bool visitContinueStmt(parser::ASTNode* node);
+
+        bool visitAssignExpr(parser::ASTNode* node) { return chain(node, "="); }
+        bool visitLogicalOrExpr(parser::ASTNode* node) { return chain(node, "||"); }
+        bool visitLogicalAndExpr(parser::ASTNode* node) { return chain(node, "&&"); }
+        bool visitEqualityExpr(parser::ASTNode* node) { return chain(node); }
+        bool visitRelationalExpr(parser::ASTNode* node) { return chain(node); }
+        bool visitAdditiveExpr(parser::ASTNode* node) { return chain(node); }
+        bool visitMultiplicativeExpr(parser::ASTNode* node) { return chain(node); }
+        bool visitUnaryExpr(parser::ASTNode* node);
+        bool visitPostfixExpr(parser::ASTNode* node);
+        bool visitArgList(parser::ASTNode* node) { return commaList(node); }
+        bool visitArrayAccess(parser::ASTNode* node);
+        bool visitParenthesizedExpr(parser::ASTNode* node);
+
+        bool visitTypeSpec(parser::ASTNode* node) { return terminal(node); }
+        bool visitIdentifier(parser::ASTNode* node) { return terminal(node); }
+        bool visitLongConst(parser::ASTNode* node) { return terminal(node); }
+        bool visitIntConst(parser::ASTNode* node) { return terminal(node); }
+        bool visitFloatConst(parser::ASTNode* node) { return terminal(node); }
+        bool visitCharConst(parser::ASTNode* node) { return terminal(node); }
+        bool visitStringConst(parser::ASTNode* node) { return terminal(node); }
+        bool visitLineComment(parser::ASTNode* node) { return comment(node); }
+        bool visitBlockComment(parser::ASTNode* node) { return comment(node); }
+
+        // 只输出表达式本身：表达式语句不带分号和换行（用于for头部）
+        bool exprOnly(parser::ASTNode* node);
+        // 只输出函数定义的头部（返回类型、名字和参数列表），不含函数体
+        bool functionHead(parser::ASTNode* node);
+
+    private:
+        parser::BufferedWriter& out;
+        int indent;
+        std::unique_ptr<Layout<Style>> layout;
+        char last = 0; // 压缩输出时已写出的最后一个字符
+        void printIndent();
+        // 输出原语：不折行时直接写出，否则追加到当前行由Layout排版；压缩输出时空白由minifyText决定
+        void text(const char* s, size_t n) {
+            if (Style::minify) minifyText(s, n);
+            else if (layout) layout->text(s, n);
+            else out.write(s, n);
+        }
+        void text(const char* s) { text(s, strlen(s)); }
+        void text(const std::string& s) { text(s.data(), s.size()); }
+        void softBreak() { // 可断点，不折行时为一个空格
+            if (Style::minify) return;
+            if (layout) layout->softBreak();
+            else out.put(' ');
+        }
+        void open() { if (layout) layout->open(); }   // 分组开始：组内的可断点一起决定是否折行
+        void close() { if (layout) layout->close(); }
+        void newline() {
+            if (Style::minify) return;
+            if (layout) layout->flushLine();
+            else out.put('\n');
+        }
+        void minifyText(const char* s, size_t n);
+        static const char* op(parser::ASTNode* node);
+        static const char* op(const std::string& name);
+        // 二元或n元运算链；fixedOp为空时运算符依次取自token
+        bool chain(parser::ASTNode* node, const char* fixedOp = nullptr);
+        bool commaList(parser::ASTNode* node);
+        void commaItems(parser::ASTNode* node);
+        bool terminal(parser::ASTNode* node);
+        bool comment(parser::ASTNode* node);
+        void parenthesized(parser::ASTNode* node); // 按风格输出带圆括号的子节点，空参数列表输出 ()
+        void ifStmt(parser::ASTNode* node, bool indentFirst);
+        void body(parser::ASTNode* stmt);
+        void blockContents(parser::ASTNode* block, bool chained = false);
+    };
+
+#define FORMATTER_EXTERN_VISITOR(S, name) extern template class FormatVisitor<S>;
+    FORMATTER_STYLES(FORMATTER_EXTERN_VISITOR)
+#undef FORMATTER_EXTERN_VISITOR
+}
+
+#endif //FORMAT_VISITOR_H
@@ -1,380 +1,67 @@
 #include "formatter.h"
+#include "format_visitor.h"
 #include "parser.h"
+#include "buffered_writer.h"
+#include "line_diff.h"
+#include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
 
 namespace formatter {
-    Formatter::Formatter(FILE *input,bool debug,std::string output):
-        debug(debug),output(output),parser(input,debug)
+    template <class Style>
+    BasicFormatter<Style>::BasicFormatter(FILE *input,bool debug,std::string output,unsigned jobs,bool hashCons,
+                                          bool flatChains):
+        debug(debug),output(output),jobs(jobs),parser(input,debug)
     {
+        parser.jobs = jobs;
+        parser.hashCons = hashCons;
+        parser.flatChains = flatChains;
         parser.parse();
     }
 
-    Formatter::~Formatter() {
-        parser.~Parser();
+    template <class Style>
+    BasicFormatter<Style>::BasicFormatter(lexer::Lexer &lexer,bool debug,std::string output,unsigned jobs,
+                                          bool hashCons,bool flatChains):
+        debug(debug),output(output),jobs(jobs),parser(lexer,debug)
+    {
+        parser.jobs = jobs;
+        parser.hashCons = hashCons;
+        parser.flatChains = flatChains;
+        parser.parse();
     }
 
-    static const std::unordered_map<std::string, std::string> operatorReplacements = {
-        {"PLUS", "+"},
-        {"MINUS", "-"},
-        {"MUL", "*"},
-        {"DIV", "/"},
-        {"MOD", "%"},
-        {"EQ", "=="},
-        {"NEQ", "!="},
-        {"LT", "<"},
-        {"GT", ">"},
-        {"LE", "<="},
-        {"GE", ">="}
-    };
+    template <class Style>
+    BasicFormatter<Style>::BasicFormatter(parser::NodeArena nodes,bool debug,std::string output):
+        debug(debug),output(output),jobs(1),parser(std::move(nodes),debug) {}
 
     // 辅助函数，递归输出表达式但不加分号和换行（主要用于for头部）
-    void Formatter::formatExprNoSemi(FILE* out, parser::ASTNode* node) {
-        if (!node) return;
-        using NT = parser::NodeType;
-        switch (node->type) {
-            case NT::ExprStmt:
-                if (!node->children.empty()) {
-                    formatExprNoSemi(out, node->children[0]);
-                }
-                break;
-            case NT::AssignExpr:
-                formatExprNoSemi(out, node->children[0]);
-                fprintf(out, " = ");
-                formatExprNoSemi(out, node->children[1]);
-                break;
-            case NT::LogicalOrExpr:
-                formatExprNoSemi(out, node->children[0]);
-                fprintf(out, " || ");
-                formatExprNoSemi(out, node->children[1]);
-                break;
-            case NT::LogicalAndExpr:
-                formatExprNoSemi(out, node->children[0]);
-                fprintf(out, " && ");
-                formatExprNoSemi(out, node->children[1]);
-                break;
-            case NT::EqualityExpr:
-            case NT::RelationalExpr:
-            case NT::AdditiveExpr:
-            case NT::MultiplicativeExpr:
-                formatExprNoSemi(out, node->children[0]);
-                fprintf(out, " %s ", operatorReplacements.at(node->token).c_str());
-                formatExprNoSemi(out, node->children[1]);
-                break;
-            case NT::UnaryExpr:
-                fprintf(out, "%s", operatorReplacements.at(node->token).c_str());
-                formatExprNoSemi(out, node->children[0]);
-                break;
-            case NT::PostfixExpr:
-                formatExprNoSemi(out, node->children[0]);
-                if (node->children.size() > 1) {
-                    fprintf(out, "(");
-                    formatExprNoSemi(out, node->children[1]);
-                    fprintf(out, ")");
-                }
-                break;
-            case NT::ArgList:
-                for (size_t i = 0; i < node->children.size(); ++i) {
-                    formatExprNoSemi(out, node->children[i]);
-                    if (i + 1 < node->children.size()) fprintf(out, ", ");
-                }
-                break;
-            case NT::ArrayAccess:
-                formatExprNoSemi(out, node->children[0]);
-                fprintf(out, "[");
-                formatExprNoSemi(out, node->children[1]);
-                fprintf(out, "]");
-                break;
-            case NT::TypeSpec:
-            case NT::Identifier:
-            case NT::LongConst:
-            case NT::IntConst:
-            case NT::FloatConst:
-            case NT::CharConst:
-            case NT::StringConst:
-                fprintf(out, "%s", node->token.c_str());
-                break;
-            default:
-                for (auto* child : node->children) formatExprNoSemi(out, child);
-                break;
-        }
+    template <class Style>
+    void BasicFormatter<Style>::formatExprNoSemi(FILE* out, parser::ASTNode* node) {
+        parser::BufferedWriter writer(out);
+        FormatVisitor<Style>(writer).exprOnly(node);
     }
 
     // 递归格式化输出AST节点为C代码
-    void Formatter::formatASTNode(FILE* out, parser::ASTNode* node, int indent) {
-        if (!node) return;
-        auto printIndent = [&](int n) { for (int i = 0; i < n; ++i) fprintf(out, "    "); };
-        using NT = parser::NodeType;
-        switch (node->type) {
-            case NT::Program:
-            case NT::ExternalDeclList:
-                for (auto* child : node->children) formatASTNode(out, child, indent);
-                break;
-            case NT::FunctionDecl: {
-                printIndent(indent);
-                formatASTNode(out, node->children[0], 0); // type
-                fprintf(out, " ");
-                formatASTNode(out, node->children[1], 0); // ident
-                fprintf(out, "(");
-                // 参数列表输出
-                if (node->children.size() > 2 && node->children[2]) {
-                    formatASTNode(out, node->children[2], 0);
-                }
-                fprintf(out, ");\n");
-                break;
-            }
-            case NT::FunctionDef: {
-                printIndent(indent);
-                formatASTNode(out, node->children[0], 0); // type
-                fprintf(out, " ");
-                formatASTNode(out, node->children[1], 0); // ident
-                fprintf(out, "(");
-                // 参数列表输出
-                if (node->children.size() > 2 && node->children[2]) {
-                    formatASTNode(out, node->children[2], 0);
-                }
-                fprintf(out, ")\n");
-                // 复合语句体
-                if (node->children.size() > 3 && node->children[3]) {
-                    formatASTNode(out, node->children[3], indent);
-                }
-                break;
-            }
-            case NT::ParamList: {
-                for (size_t i = 0; i < node->children.size(); ++i) {
-                    formatASTNode(out, node->children[i], 0);
-                    if (i + 1 < node->children.size()) fprintf(out, ", ");
-                }
-                break;
-            }
-            case NT::Param: {
-                formatASTNode(out, node->children[0], 0); // type
-                fprintf(out, " ");
-                formatASTNode(out, node->children[1], 0); // ident
-                // 无论有无第三个子节点，只要是数组类型都输出
-                for (size_t i = 2; i < node->children.size(); ++i) {
-                    if (node->children[i] && node->children[i]->type == NT::ArrayType) {
-                        formatASTNode(out, node->children[i], 0); // arrayType
-                    }
-                }
-                break;
-            }
-            case NT::ArrayType: {
-                for (auto* dim : node->children) {
-                    fprintf(out, "[");
-                    formatASTNode(out, dim, 0);
-                    fprintf(out, "]");
-                }
-                break;
-            }
-            case NT::VarDecl:
-            case NT::LocalVarDecl: {
-                printIndent(indent);
-                formatASTNode(out, node->children[0], 0); // type
-                fprintf(out, " ");
-                formatASTNode(out, node->children[1], 0); // ident
-                // 数组类型
-                int idx = 2;
-                if (node->children.size() > idx && node->children[idx]->type == NT::ArrayType) {
-                    formatASTNode(out, node->children[idx], 0);
-                    ++idx;
-                }
-                // 赋值
-                if (node->children.size() > idx) {
-                    fprintf(out, " = ");
-                    formatASTNode(out, node->children[idx], 0);
-                }
-                fprintf(out, ";\n");
-                break;
-            }
-            case NT::CompoundStmt: {
-                printIndent(indent);
-                fprintf(out, "{\n");
-                // 局部变量定义
-                if (!node->children.empty())
-                    formatASTNode(out, node->children[0], indent + 1);
-                // 语句列表
-                if (node->children.size() > 1)
-                    formatASTNode(out, node->children[1], indent + 1);
-                printIndent(indent);
-                fprintf(out, "}\n");
-                break;
-            }
-            case NT::VarDeclList: {
-                for (auto* child : node->children) formatASTNode(out, child, indent);
-                break;
-            }
-            case NT::StmtList: {
-                for (auto* child : node->children) formatASTNode(out, child, indent);
-                break;
-            }
-            case NT::ExprStmt: {
-                printIndent(indent);
-                if (!node->children.empty()) {
-                    formatASTNode(out, node->children[0], 0);
-                }
-                fprintf(out, ";\n");
-                break;
-            }
-            case NT::IfStmt: {
-                printIndent(indent);
-                fprintf(out, "if (");
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, ")\n");
-                formatASTNode(out, node->children[1], indent);
-                if (node->children.size() == 3) {
-                    printIndent(indent);
-                    fprintf(out, "else\n");
-                    formatASTNode(out, node->children[2], indent);
-                }
-                break;
-            }
-            case NT::WhileStmt: {
-                printIndent(indent);
-                fprintf(out, "while (");
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, ")\n");
-                formatASTNode(out, node->children[1], indent);
-                break;
-            }
-            case NT::ForStmt: {
-                printIndent(indent);
-                fprintf(out, "for (");
-                formatExprNoSemi(out, node->children[0]); fprintf(out, "; ");
-                formatExprNoSemi(out, node->children[1]); fprintf(out, "; ");
-                formatExprNoSemi(out, node->children[2]);
-                fprintf(out, ")\n");
-                formatASTNode(out, node->children[3], indent);
-                break;
-            }
-            case NT::ReturnStmt: {
-                printIndent(indent);
-                fprintf(out, "return");
-                if (!node->children.empty()) {
-                    fprintf(out, " ");
-                    formatASTNode(out, node->children[0], 0);
-                }
-                fprintf(out, ";\n");
-                break;
-            }
-            case NT::BreakStmt: {
-                printIndent(indent);
-                fprintf(out, "break;\n");
-                break;
-            }
-            case NT::ContinueStmt: {
-                printIndent(indent);
-                fprintf(out, "continue;\n");
-                break;
-            }
-            case NT::AssignExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " = ");
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::LogicalOrExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " || ");
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::LogicalAndExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " && ");
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::EqualityExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " %s ", operatorReplacements.at(node->token).c_str());
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::RelationalExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " %s ", operatorReplacements.at(node->token).c_str());
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::AdditiveExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " %s ", operatorReplacements.at(node->token).c_str());
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::MultiplicativeExpr: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, " %s ", operatorReplacements.at(node->token).c_str());
-                formatASTNode(out, node->children[1], 0);
-                break;
-            }
-            case NT::UnaryExpr: {
-                fprintf(out, "%s", operatorReplacements.at(node->token).c_str());
-                formatASTNode(out, node->children[0], 0);
-                break;
-            }
-            case NT::PostfixExpr: {
-                formatASTNode(out, node->children[0], 0); // ident
-                if (node->children.size() > 1) {
-                    fprintf(out, "(");
-                    formatASTNode(out, node->children[1], 0);
-                    fprintf(out, ")");
-                }
-                break;
-            }
-            case NT::ArgList: {
-                for (size_t i = 0; i < node->children.size(); ++i) {
-                    formatASTNode(out, node->children[i], 0);
-                    if (i + 1 < node->children.size()) fprintf(out, ", ");
-                }
-                break;
-            }
-            case NT::ArrayAccess: {
-                formatASTNode(out, node->children[0], 0);
-                fprintf(out, "[");
-                formatASTNode(out, node->children[1], 0);
-                fprintf(out, "]");
-                break;
-            }
-            case NT::TypeSpec:
-            case NT::Identifier:
-            case NT::LongConst:
-            case NT::IntConst:
-            case NT::FloatConst:
-            case NT::CharConst:
-            case NT::StringConst: {
-                fprintf(out, "%s", node->token.c_str());
-                break;
-            }
-            case NT::ParenthesizedExpr: {
-                fprintf(out, "(");
-                if (!node->children.empty()) {
-                    formatASTNode(out, node->children[0], 0);
-                }
-                fprintf(out, ")");
-                break;
-            }
-            case NT::LineComment: {
-                printIndent(indent);
-                fprintf(out, "%s\n", node->token.c_str());
-                break;
-            }
-            case NT::BlockComment: {
-                printIndent(indent);
-                fprintf(out, "%s\n", node->token.c_str());
-                break;
-            }
-            default:
-                for (auto* child : node->children) formatASTNode(out, child, indent);
-                break;
-        }
+    template <class Style>
+    void BasicFormatter<Style>::formatASTNode(FILE* out, parser::ASTNode* node, int indent) {
+        parser::BufferedWriter writer(out);
+        FormatVisitor<Style>(writer, indent).traverse(node);
+    }
+
+    // 按输入大小估计输出缓冲区容量，使整个输出通常只需一次写出
+    // 格式化后的代码比原Token文本多出缩进、空格和换行，按1.5倍预留；从缓存载入的AST没有Token，用默认容量
+    static size_t outputCapacity(size_t textSize) {
+        const size_t minCapacity = 1 << 16;
+        const size_t maxCapacity = 32 << 20;
+        size_t estimate = textSize + textSize / 2 + 4096;
+        return std::min(std::max(estimate, minCapacity), maxCapacity);
     }
 
-    void Formatter::format() {
+    template <class Style>
+    void BasicFormatter<Style>::format() {
         std::string outFile = output;
         if (outFile.empty()) outFile = "formatted.c";
         FILE *out = fopen(outFile.c_str(), "w");
@@ -382,8 +69,127 @@ namespace formatter {
             std::cerr << "Cannot open output file: " << outFile << std::endl;
             return;
         }
+        parser::BufferedWriter writer(out, outputCapacity(parser.textSize()));
+        format(writer);
+        if (!writer.flush()) std::cerr << "Failed to write output file: " << outFile << std::endl;
+        fclose(out);
+    }
+
+    template <class Style>
+    void BasicFormatter<Style>::format(parser::BufferedWriter& out) {
         parser::ASTNode* root = parser.parse();
-        formatASTNode(out, root, 0);
+        // 压缩输出的片段拼接依赖前一片段的结尾，不按声明并行
+        if (jobs > 1 && !Style::minify) {
+            formatParallel(out, root);
+        } else {
+            FormatVisitor<Style>(out, 0, width).traverse(root);
+        }
+    }
+
+    bool readFile(const std::string& filename, std::string& data) {
+        FILE* file = fopen(filename.c_str(), "rb");
+        if (!file) return false;
+        char chunk[1 << 16];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) data.append(chunk, n);
+        fclose(file);
+        return true;
+    }
+
+    template <class Style>
+    CheckResult BasicFormatter<Style>::check(const std::string& filename, bool debug, bool flatChains, int width) {
+        FILE *input = fopen(filename.c_str(), "r");
+        FILE *expected = input ? fopen(filename.c_str(), "rb") : nullptr;
+        if (!expected) {
+            if (input) fclose(input);
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            return CheckResult::Failed;
+        }
+        lexer::Lexer source(input);
+        parser::Parser parser(std::vector<lexer::Token>{}, debug);
+        parser.flatChains = flatChains;
+        size_t declCount = 0;
+        bool same;
+        {
+            parser::BufferedWriter compare(expected, parser::BufferedWriter::Compare);
+            auto sink = [&compare, width](parser::ASTNode* decl) {
+                FormatVisitor<Style>(compare, 0, width).traverse(decl);
+                delete decl;
+            };
+            parser::TopLevelReader reader(source);
+            std::vector<lexer::Token> chunk;
+            // 每个声明格式化后立即比较，一旦不同就不再继续词法和语法分析
+            while (parser.diagnostics.empty() && compare.flush() && reader.next(chunk)) {
+                declCount += parser.parseChunk(std::move(chunk), reader.chunkBegin(), sink);
+            }
+            same = parser.diagnostics.empty() && compare.matchesToEnd();
+            if (!same && parser.diagnostics.empty()) {
+                std::cout << filename << ": first difference at line " << compare.matchedLines() + 1
+                          << " (byte " << compare.matchedBytes() << ")" << std::endl;
+            }
+        }
+        fclose(expected);
+        if (declCount == 0 && parser.diagnostics.empty()) {
+            std::cerr << "Parse error: program: expected at least one external declaration" << std::endl;
+        }
+        if (!parser.diagnostics.empty() || declCount == 0) return CheckResult::Failed;
+        return same ? CheckResult::Formatted : CheckResult::Unformatted;
+    }
+
+    // 源码只读入一次，词法分析直接读这块内存；源码和格式化结果都整体留在内存中，差异直接在两块缓冲区上按行计算
+    template <class Style>
+    CheckResult BasicFormatter<Style>::diff(const std::string& filename, FILE* out, bool debug, unsigned jobs,
+                                            bool flatChains, int width) {
+        std::string source;
+        if (!readFile(filename, source)) {
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            return CheckResult::Failed;
+        }
+        lexer::Lexer lexer(source.data(), source.size());
+        BasicFormatter formatter(lexer, debug, "", jobs, false, flatChains);
+        if (formatter.hasErrors()) return CheckResult::Failed;
+        formatter.width = width;
+        parser::BufferedWriter formatted(nullptr, outputCapacity(formatter.parser.textSize()));
+        formatter.format(formatted);
+        parser::BufferedWriter writer(out);
+        bool changed = unifiedDiff(source.data(), source.size(), formatted.data(), formatted.size(), "a/" + filename,
+                                   "b/" + filename, writer);
+        if (!writer.flush()) {
+            std::cerr << "Failed to write diff" << std::endl;
+            return CheckResult::Failed;
+        }
+        return changed ? CheckResult::Unformatted : CheckResult::Formatted;
+    }
+
+    template <class Style>
+    bool BasicFormatter<Style>::formatStream(FILE *input, const std::string& output, bool debug, bool hashCons,
+                                             bool flatChains, int width) {
+        lexer::Lexer source(input);
+        std::string outFile = output;
+        if (outFile.empty()) outFile = "formatted.c";
+        FILE *out = fopen(outFile.c_str(), "w");
+        if (!out) {
+            std::cerr << "Cannot open output file: " << outFile << std::endl;
+            return false;
+        }
+        parser::Parser parser(std::vector<lexer::Token>{}, debug);
+        parser.hashCons = hashCons;
+        parser.flatChains = flatChains;
+        bool written;
+        {
+            parser::BufferedWriter writer(out);
+            parser.parseStream(source, [&writer, width](parser::ASTNode* decl) {
+                FormatVisitor<Style>(writer, 0, width).traverse(decl);
+                delete decl;
+            });
+            written = writer.flush();
+        }
+        if (!written) std::cerr << "Failed to write output file: " << outFile << std::endl;
         fclose(out);
+        return written && parser.diagnostics.empty();
     }
-}
\ No newline at end of file
+
+#define FORMATTER_INSTANTIATE_FORMATTER(S, name) template class BasicFormatter<S>;
+    FORMATTER_STYLES(FORMATTER_INSTANTIATE_FORMATTER)
+#undef FORMATTER_INSTANTIATE_FORMATTER
+}
@@ -1,21 +1,75 @@
 #ifndef FORMATTER_H
 #define FORMATTER_H
 #include <string>
+#include <vector>
 #include "parser.h"
+#include "buffered_writer.h"
+#include "style.h"
 
 namespace formatter {
-    class Formatter {
+    // 源码中的行区间，行号从1开始，含两端
+    struct LineRange {
+        int first;
+        int last;
+    };
+
+    // 检查模式的结果
+    enum class CheckResult {
+        Formatted,   // 输出与输入相同
+        Unformatted, // 格式化会改变文件
+        Failed       // 无法读取或有语法错误
+    };
+
+    // 格式化器，输出风格由Style在编译期确定（见style.h）；各预置风格在formatter模块内显式实例化
+    template <class Style>
+    class BasicFormatter {
     public:
-        explicit Formatter(FILE *input,bool debug=false,std::string output="formatted");
-        ~Formatter();
+        explicit BasicFormatter(FILE *input,bool debug=false,std::string output="formatted",unsigned jobs=1,
+                                bool hashCons=false,bool flatChains=false);
+        // 从调用方的词法分析器取Token，如内存中的源码；lexer仍归调用方
+        explicit BasicFormatter(lexer::Lexer &lexer,bool debug=false,std::string output="formatted",unsigned jobs=1,
+                                bool hashCons=false,bool flatChains=false);
+        explicit BasicFormatter(parser::NodeArena nodes,bool debug=false,std::string output="formatted");
         bool debug;
         std::string output;
+        unsigned jobs; // 大于1时解析和格式化都按顶层声明多线程进行，输出与单线程相同
+        int width = 0; // 列宽限制，超出的行在运算符、逗号等处折行；0表示不折行
         void format();
+        void format(parser::BufferedWriter& out); // 输出到给定的缓冲区，如内存缓冲区
+        // 流式格式化：每解析完一个顶层声明就格式化输出并释放，不建立整棵AST，input由本函数关闭
+        // 返回输出成功且没有语法错误
+        static bool formatStream(FILE *input, const std::string& output, bool debug = false, bool hashCons = false,
+                                 bool flatChains = false, int width = 0);
+        // 检查模式：逐个顶层声明流式格式化并与输入比较，遇到第一个不同的字节即停止，不写任何文件
+        static CheckResult check(const std::string& filename, bool debug = false, bool flatChains = false, int width = 0);
+        // 区间格式化：只重新格式化与lines相交的顶层声明或语句，其余字节从源码原样复制；
+        // 读过最后一个区间后不再做词法分析。返回输出成功且涉及的部分没有语法错误
+        static bool formatLines(const std::string& filename, const std::string& output, std::vector<LineRange> lines,
+                                bool debug = false, bool flatChains = false, int width = 0);
+        // 保留trivia的格式化：注释和格式已正确处的空白原样保留，只改写需要调整的空白；注释可以出现在任意两个Token之间
+        // 格式化改变了Token序列（不应发生）时不写文件；返回输出成功且没有语法错误
+        static bool formatTrivia(const std::string& filename, const std::string& output, bool debug = false,
+                                 bool flatChains = false, int width = 0);
+        // 差异模式：把输入到格式化结果的统一格式差异（unified diff）写到out，不写文件；返回值含义同检查模式
+        static CheckResult diff(const std::string& filename, FILE* out, bool debug = false, unsigned jobs = 1,
+                                bool flatChains = false, int width = 0);
         void formatASTNode(FILE* out,  parser::ASTNode* node, int indent = 0);
         void formatExprNoSemi(FILE* out, parser::ASTNode* node);
+        parser::ASTNode* root() { return parser.parse(); }
+        parser::Parser& syntax() { return parser; } // 本次解析的Token和AST，可用于在同一次解析上输出其他结果
+        bool hasErrors() const { return !parser.diagnostics.empty(); } // 有语法错误时只格式化了未受影响的声明
     private:
         parser::Parser parser;
+        void formatParallel(parser::BufferedWriter& out, parser::ASTNode* root);
     };
+
+    using Formatter = BasicFormatter<AllmanStyle>; // 默认风格
+
+#define FORMATTER_EXTERN_FORMATTER(S, name) extern template class BasicFormatter<S>;
+    FORMATTER_STYLES(FORMATTER_EXTERN_FORMATTER)
+#undef FORMATTER_EXTERN_FORMATTER
+
+    bool readFile(const std::string& filename, std::string& data); // 整个文件按字节读入
 }
 
 #endif //FORMATTER_H
\ No newline at end of file
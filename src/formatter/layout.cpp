@@ -0,0 +1,97 @@
+#include "layout.h"
+
+namespace formatter {
+    template <class Style>
+    void Layout<Style>::flushLine() {
+        int indentCols = Style::indentWidth * base;
+        int flatWidth = 0;
+        for (const auto& item : items) flatWidth += item.len;
+        Style::indent(out, base);
+        // 绝大多数行放得下，直接平铺输出
+        if (width <= 0 || indentCols + flatWidth <= width) {
+            writeFlat();
+        } else {
+            writeBroken();
+        }
+        out.put('\n');
+        items.clear();
+        base = 0;
+    }
+
+    template <class Style>
+    void Layout<Style>::writeFlat() {
+        for (const auto& item : items) {
+            if (item.len) out.write(item.text, item.len);
+        }
+    }
+
+    template <class Style>
+    void Layout<Style>::writeBroken() {
+        int n = static_cast<int>(items.size());
+        prefix.assign(n + 1, 0);
+        for (int i = 0; i < n; ++i) prefix[i + 1] = prefix[i] + items[i].len;
+        // 自后向前求每个可断点和分组之后的下一个同层或外层可断点，内层组的可断点按平铺跳过
+        // nearest[d]：已扫过的部分中，嵌套深度不超过d的最近可断点
+        stop.assign(n, n);
+        nearest.assign(1, n);
+        for (int i = n - 1; i >= 0; --i) {
+            switch (items[i].kind) {
+                case Close:
+                    nearest.push_back(nearest.back());
+                    break;
+                case Open:
+                    if (nearest.size() > 1) nearest.pop_back();
+                    stop[i] = nearest.back();
+                    break;
+                case Break:
+                    stop[i] = nearest.back();
+                    nearest.back() = i;
+                    break;
+                case Text:
+                    break;
+            }
+        }
+
+        int column = Style::indentWidth * base;
+        groups.clear();
+        groups.push_back({column, column, true, true}); // 分组之外的可断点不折行
+        for (int i = 0; i < n; ++i) {
+            const auto& item = items[i];
+            switch (item.kind) {
+                case Text:
+                    out.write(item.text, item.len);
+                    column += item.len;
+                    break;
+                case Open: {
+                    const auto& outer = groups.back();
+                    // 续行缩进比最近一个已折行的外层组多一级；外层组平铺时内层必然平铺，最外层的占位组不参与
+                    int anchor = outer.broken ? outer.indent : outer.anchor;
+                    bool flat = (groups.size() > 1 && outer.flat) || column + prefix[stop[i]] - prefix[i] <= width;
+                    groups.push_back({anchor + Style::indentWidth, anchor, flat, false});
+                    break;
+                }
+                case Close:
+                    if (groups.size() > 1) groups.pop_back();
+                    break;
+                case Break: {
+                    auto& group = groups.back();
+                    // 填充方式：到下一个同层可断点为止的内容放得下就不换行
+                    if (group.flat || column + item.len + prefix[stop[i]] - prefix[i + 1] <= width) {
+                        out.put(' ');
+                        column += item.len;
+                    } else {
+                        out.put('\n');
+                        Style::indent(out, group.indent / Style::indentWidth);
+                        column = group.indent;
+                        group.broken = true;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+#define FORMATTER_INSTANTIATE_LAYOUT(S, name) template class Layout<S>;
+    FORMATTER_STYLES(FORMATTER_INSTANTIATE_LAYOUT)
+#undef FORMATTER_INSTANTIATE_LAYOUT
+}
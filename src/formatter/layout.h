@@ -0,0 +1,59 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+#include <cstddef>
+#include <vector>
+#include "buffered_writer.h"
+#include "style.h"
+
+namespace formatter {
+    // 按列宽折行的单行排版（Oppen式文档流）：
+    // - 一行由文本、可断点、分组开始和分组结束组成，FormatVisitor逐项追加，行尾调用flushLine排版输出
+    // - 分组放得下（含其后直到下一个同层或外层可断点的文本）时整组不断行，否则组内可断点按填充方式折行：
+    //   到下一个同层可断点的内容放不下才换行，续行缩进比最近一个已折行的外层多一级（级宽由Style决定）
+    // - 平铺宽度用前缀和一次算出，各组和各段的宽度由此直接相减得到，排版一行的时间与该行项数成线性
+    template <class Style>
+    class Layout {
+    public:
+        Layout(parser::BufferedWriter& out, int width) : out(out), width(width) {}
+        void startLine(int level) { base = level; }
+        // 文本须在flushLine之前保持有效（取自AST节点或静态字符串）
+        void text(const char* s, size_t n) { items.push_back({Text, s, static_cast<int>(n)}); }
+        void softBreak() { items.push_back({Break, " ", 1}); } // 平铺时输出一个空格
+        void open() { items.push_back({Open, nullptr, 0}); }
+        void close() { items.push_back({Close, nullptr, 0}); }
+        void flushLine(); // 排版并输出当前行及换行符，然后清空
+
+    private:
+        enum Kind { Text, Break, Open, Close };
+        struct Item {
+            Kind kind;
+            const char* text;
+            int len;
+        };
+        struct Group {
+            int indent; // 该组折行后续行的缩进列
+            int anchor; // 最近一个已折行的外层组的续行缩进，没有则为行首缩进
+            bool flat;
+            bool broken; // 已经折过行
+        };
+
+        parser::BufferedWriter& out;
+        int width;
+        int base = 0; // 当前行的缩进级数
+        std::vector<Item> items;
+        // 排版时的工作数组，跨行复用
+        std::vector<int> prefix;  // prefix[i]：第i项之前的平铺宽度
+        std::vector<int> stop;    // 可断点或分组开始之后，下一个同层或外层可断点的下标，没有则为项数
+        std::vector<int> nearest;
+        std::vector<Group> groups;
+
+        void writeFlat();
+        void writeBroken();
+    };
+
+#define FORMATTER_EXTERN_LAYOUT(S, name) extern template class Layout<S>;
+    FORMATTER_STYLES(FORMATTER_EXTERN_LAYOUT)
+#undef FORMATTER_EXTERN_LAYOUT
+}
+
+#endif //LAYOUT_H
@@ -0,0 +1,244 @@
+#include "line_diff.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace formatter {
+    namespace {
+        // 文本中的一行，指向原缓冲区
+        struct Line {
+            const char* data; // 不含换行符
+            size_t size;
+            uint64_t hash;
+            bool newline; // 以换行符结尾，只有最后一行可能没有
+        };
+
+        std::vector<Line> splitLines(const char* text, size_t size) {
+            std::vector<Line> lines;
+            size_t begin = 0;
+            while (begin < size) {
+                const char* nl = static_cast<const char*>(memchr(text + begin, '\n', size - begin));
+                size_t end = nl ? static_cast<size_t>(nl - text) : size;
+                uint64_t h = 0xCBF29CE484222325ULL; // FNV-1a
+                for (size_t i = begin; i < end; ++i) {
+                    h ^= static_cast<unsigned char>(text[i]);
+                    h *= 0x100000001B3ULL;
+                }
+                lines.push_back({text + begin, end - begin, h, nl != nullptr});
+                begin = end + 1;
+            }
+            return lines;
+        }
+
+        // 线性空间的Myers差分：每次从两端同时搜索，在正反两条路径相遇处把问题一分为二递归求解
+        // 正反向各只保留一行对角线数组，额外空间为O(N+M)
+        class MyersDiff {
+        public:
+            MyersDiff(const std::vector<Line>& a, const std::vector<Line>& b)
+                : removed(a.size()), added(b.size()), a(a), b(b) {
+                int n = static_cast<int>(a.size() + b.size());
+                offset = n + 1;
+                forward.resize(2 * static_cast<size_t>(n) + 3);
+                backward.resize(2 * static_cast<size_t>(n) + 3);
+                maxCost = 256;
+                while (static_cast<long long>(maxCost) * maxCost < n) maxCost *= 2;
+            }
+
+            void run() { compare(0, static_cast<int>(a.size()), 0, static_cast<int>(b.size())); }
+
+            std::vector<char> removed; // removed[i]：旧文本第i行被删除
+            std::vector<char> added;   // added[j]：新文本第j行是新增的
+
+        private:
+            const std::vector<Line>& a;
+            const std::vector<Line>& b;
+            int offset; // 对角线编号k（可为负）存于下标k+offset
+            int maxCost; // 每次分割最多搜索的步数，约为总行数的平方根，至少256
+            std::vector<int> forward;  // 正向：各对角线上到达的最大x
+            std::vector<int> backward; // 反向：各对角线上到达的最小x
+
+            bool equal(int i, int j) const {
+                const Line& x = a[i];
+                const Line& y = b[j];
+                return x.hash == y.hash && x.size == y.size && x.newline == y.newline &&
+                       memcmp(x.data, y.data, x.size) == 0;
+            }
+
+            void compare(int a0, int a1, int b0, int b1) {
+                while (a0 < a1 && b0 < b1 && equal(a0, b0)) ++a0, ++b0;
+                while (a0 < a1 && b0 < b1 && equal(a1 - 1, b1 - 1)) --a1, --b1;
+                if (a0 == a1) {
+                    std::fill(added.begin() + b0, added.begin() + b1, 1);
+                } else if (b0 == b1) {
+                    std::fill(removed.begin() + a0, removed.begin() + a1, 1);
+                } else {
+                    int x, y;
+                    split(a0, a1, b0, b1, x, y);
+                    if ((x == a0 && y == b0) || (x == a1 && y == b1)) {
+                        // 分割没有进展时（只可能出现在放弃求最短之后）整段按删除再新增处理
+                        std::fill(removed.begin() + a0, removed.begin() + a1, 1);
+                        std::fill(added.begin() + b0, added.begin() + b1, 1);
+                        return;
+                    }
+                    compare(a0, x, b0, y);
+                    compare(x, a1, y, b1);
+                }
+            }
+
+            // 求最短编辑路径上的一个中间点(x, y)。两端已去掉相同的行，所以该点通常不会是两个端点
+            // 对角线k上的点满足 x - y = k（坐标相对a0、b0），只在网格内的对角线范围[-M, N]上搜索
+            void split(int a0, int a1, int b0, int b1, int& x, int& y) {
+                const int n = a1 - a0;
+                const int m = b1 - b0;
+                const int kmin = -m;
+                const int kmax = n;
+                const int delta = n - m;
+                const bool odd = (delta & 1) != 0;
+                int* fv = forward.data() + offset;
+                int* bv = backward.data() + offset;
+                int fmin = 0, fmax = 0, bmin = delta, bmax = delta;
+                fv[0] = 0;
+                bv[delta] = n;
+                for (int cost = 1;; ++cost) {
+                    // 正向多走一步：每条对角线由相邻对角线走一步再沿相同的行滑到尽头
+                    if (fmin > kmin) fv[--fmin - 1] = -1;
+                    else ++fmin;
+                    if (fmax < kmax) fv[++fmax + 1] = -1;
+                    else --fmax;
+                    for (int k = fmax; k >= fmin; k -= 2) {
+                        int i = fv[k - 1] >= fv[k + 1] ? fv[k - 1] + 1 : fv[k + 1];
+                        int j = i - k;
+                        while (i < n && j < m && equal(a0 + i, b0 + j)) ++i, ++j;
+                        fv[k] = i;
+                        if (odd && bmin <= k && k <= bmax && bv[k] <= i) {
+                            x = a0 + i;
+                            y = b0 + j;
+                            return;
+                        }
+                    }
+                    // 反向多走一步
+                    if (bmin > kmin) bv[--bmin - 1] = n + 1;
+                    else ++bmin;
+                    if (bmax < kmax) bv[++bmax + 1] = n + 1;
+                    else --bmax;
+                    for (int k = bmax; k >= bmin; k -= 2) {
+                        int i = bv[k - 1] < bv[k + 1] ? bv[k - 1] : bv[k + 1] - 1;
+                        int j = i - k;
+                        while (i > 0 && j > 0 && equal(a0 + i - 1, b0 + j - 1)) --i, --j;
+                        bv[k] = i;
+                        if (!odd && fmin <= k && k <= fmax && i <= fv[k]) {
+                            x = a0 + i;
+                            y = b0 + j;
+                            return;
+                        }
+                    }
+                    // 差异太多时不再求最短，取两个方向中走得最远的点分割，结果仍正确但可能不是最少的行
+                    if (cost >= maxCost) {
+                        int fbest = -1, fk = 0;
+                        for (int k = fmax; k >= fmin; k -= 2) {
+                            int i = std::min(fv[k], n);
+                            if (i - k > m) i = m + k;
+                            if (2 * i - k > fbest) fbest = 2 * i - k, fk = k;
+                        }
+                        int bbest = n + m + 1, bk = 0;
+                        for (int k = bmax; k >= bmin; k -= 2) {
+                            int i = std::max(bv[k], 0);
+                            if (i - k < 0) i = k;
+                            if (2 * i - k < bbest) bbest = 2 * i - k, bk = k;
+                        }
+                        if ((n + m) - bbest < fbest) {
+                            x = a0 + (fbest + fk) / 2;
+                            y = b0 + (fbest - fk) / 2;
+                        } else {
+                            x = a0 + (bbest + bk) / 2;
+                            y = b0 + (bbest - bk) / 2;
+                        }
+                        return;
+                    }
+                }
+            }
+        };
+
+        // 一段连续的改动：旧文本[oldBegin, oldEnd)换成新文本[newBegin, newEnd)
+        struct Change {
+            int oldBegin, oldEnd;
+            int newBegin, newEnd;
+        };
+
+        void writeLine(parser::BufferedWriter& out, char tag, const Line& line) {
+            out.put(tag);
+            out.write(line.data, line.size);
+            out.put('\n');
+            if (!line.newline) out.write("\\ No newline at end of file\n");
+        }
+
+        // 区间头中的起始行号和行数：行数为1时省略，为0时起始行号取前一行
+        void writeRange(parser::BufferedWriter& out, int begin, int count) {
+            out.writeInt(count == 0 ? begin : begin + 1);
+            if (count != 1) {
+                out.put(',');
+                out.writeInt(count);
+            }
+        }
+    }
+
+    bool unifiedDiff(const char* oldText, size_t oldSize, const char* newText, size_t newSize,
+                     const std::string& oldLabel, const std::string& newLabel, parser::BufferedWriter& out,
+                     int context) {
+        std::vector<Line> a = splitLines(oldText, oldSize);
+        std::vector<Line> b = splitLines(newText, newSize);
+        MyersDiff diff(a, b);
+        diff.run();
+
+        std::vector<Change> changes;
+        int i = 0, j = 0;
+        const int n = static_cast<int>(a.size());
+        const int m = static_cast<int>(b.size());
+        while (i < n || j < m) {
+            if (i < n && j < m && !diff.removed[i] && !diff.added[j]) {
+                ++i, ++j;
+                continue;
+            }
+            Change c{i, i, j, j};
+            while (c.oldEnd < n && diff.removed[c.oldEnd]) ++c.oldEnd;
+            while (c.newEnd < m && diff.added[c.newEnd]) ++c.newEnd;
+            changes.push_back(c);
+            i = c.oldEnd;
+            j = c.newEnd;
+        }
+        if (changes.empty()) return false;
+
+        out.write("--- ");
+        out.write(oldLabel);
+        out.write("\n+++ ");
+        out.write(newLabel);
+        out.put('\n');
+        // 相邻改动之间的相同行不超过两倍上下文时并入同一块
+        for (size_t first = 0; first < changes.size();) {
+            size_t last = first;
+            while (last + 1 < changes.size() && changes[last + 1].oldBegin - changes[last].oldEnd <= 2 * context) ++last;
+            int lead = std::min(context, changes[first].oldBegin);
+            int trail = std::min(context, n - changes[last].oldEnd);
+            int oldBegin = changes[first].oldBegin - lead;
+            int newBegin = changes[first].newBegin - lead;
+            int oldEnd = changes[last].oldEnd + trail;
+            int newEnd = changes[last].newEnd + trail;
+            out.write("@@ -");
+            writeRange(out, oldBegin, oldEnd - oldBegin);
+            out.write(" +");
+            writeRange(out, newBegin, newEnd - newBegin);
+            out.write(" @@\n");
+            int oi = oldBegin;
+            for (size_t c = first; c <= last; ++c) {
+                for (; oi < changes[c].oldBegin; ++oi) writeLine(out, ' ', a[oi]);
+                for (int k = changes[c].oldBegin; k < changes[c].oldEnd; ++k) writeLine(out, '-', a[k]);
+                for (int k = changes[c].newBegin; k < changes[c].newEnd; ++k) writeLine(out, '+', b[k]);
+                oi = changes[c].oldEnd;
+            }
+            for (; oi < oldEnd; ++oi) writeLine(out, ' ', a[oi]);
+            first = last + 1;
+        }
+        return true;
+    }
+}
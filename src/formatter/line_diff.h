@@ -0,0 +1,17 @@
+#ifndef LINE_DIFF_H
+#define LINE_DIFF_H
+#include <cstddef>
+#include <string>
+#include "buffered_writer.h"
+
+namespace formatter {
+    // 按行比较old和new两段文本，把差异以统一格式（unified diff，context行上下文）写到out，返回是否有差异
+    // - 行只记录在原缓冲区中的位置和哈希，不复制文本
+    // - 先去掉相同的前缀和后缀，剩余部分用线性空间的Myers算法（中间蛇分治）求最短编辑序列，
+    //   时间O((N+M)D)，D为不同的行数，改动少的大文件接近线性；D过大时不再求最短，保证时间可控
+    bool unifiedDiff(const char* oldText, size_t oldSize, const char* newText, size_t newSize,
+                     const std::string& oldLabel, const std::string& newLabel, parser::BufferedWriter& out,
+                     int context = 3);
+}
+
+#endif //LINE_DIFF_H
@@ -0,0 +1,116 @@
+#include "formatter.h"
+#include "format_visitor.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace formatter {
+    using NT = parser::NodeType;
+
+    namespace {
+        // 并行格式化的输出单位，按源码顺序排列，依次输出即得到与串行完全相同的结果
+        struct FormatPiece {
+            enum Kind { Node, FunctionHead, Text } kind;
+            parser::ASTNode* node;
+            int indent;
+            const char* text;
+            size_t weight; // 估计的工作量，取节点覆盖的Token数
+        };
+
+        size_t weightOf(const parser::ASTNode* node) {
+            if (node->firstToken >= 0 && node->lastToken >= node->firstToken) {
+                return static_cast<size_t>(node->lastToken - node->firstToken + 1);
+            }
+            return 1; // 没有Token区间（如从缓存加载）时按节点个数计
+        }
+
+        // 工作量超过limit的函数定义拆到函数体语句一级：函数头、括号和每条语句各成一个单位
+        void collectPieces(parser::ASTNode* root, size_t limit, std::vector<FormatPiece>& pieces) {
+            if (!root || root->children.empty()) return;
+            for (auto* decl : root->children[0]->children) {
+                size_t weight = weightOf(decl);
+                bool split = weight > limit && decl->type == NT::FunctionDef && decl->children.size() > 3 &&
+                             decl->children[3]->type == NT::CompoundStmt;
+                if (!split) {
+                    pieces.push_back({FormatPiece::Node, decl, 0, nullptr, weight});
+                    continue;
+                }
+                pieces.push_back({FormatPiece::FunctionHead, decl, 0, nullptr, 1});
+                pieces.push_back({FormatPiece::Text, nullptr, 0, "{\n", 1});
+                for (auto* child : decl->children[3]->children) {
+                    if (child->type == NT::StmtList) {
+                        for (auto* stmt : child->children) {
+                            pieces.push_back({FormatPiece::Node, stmt, 1, nullptr, weightOf(stmt)});
+                        }
+                    } else {
+                        pieces.push_back({FormatPiece::Node, child, 1, nullptr, weightOf(child)});
+                    }
+                }
+                pieces.push_back({FormatPiece::Text, nullptr, 0, "}\n", 1});
+            }
+        }
+
+        template <class Style>
+        void formatPiece(parser::BufferedWriter& out, const FormatPiece& piece, int width) {
+            switch (piece.kind) {
+                case FormatPiece::Node:
+                    FormatVisitor<Style>(out, piece.indent, width).traverse(piece.node);
+                    break;
+                case FormatPiece::FunctionHead:
+                    FormatVisitor<Style>(out, piece.indent, width).functionHead(piece.node);
+                    break;
+                case FormatPiece::Text:
+                    Style::indent(out, piece.indent);
+                    out.write(piece.text);
+                    break;
+            }
+        }
+    }
+
+    // 并行格式化：输出单位按工作量连续分块，各块在工作线程上写入各自的内存缓冲区，再按源码顺序拼接
+    template <class Style>
+    void BasicFormatter<Style>::formatParallel(parser::BufferedWriter& out, parser::ASTNode* root) {
+        size_t total = root ? weightOf(root) : 0;
+        // 每个线程平均分到若干块，负载不均时先做完的线程继续取下一块
+        size_t target = std::max<size_t>(total / (static_cast<size_t>(jobs) * 8), 1);
+        std::vector<FormatPiece> pieces;
+        collectPieces(root, target, pieces);
+
+        std::vector<std::pair<size_t, size_t>> chunks;
+        size_t start = 0;
+        size_t weight = 0;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            weight += pieces[i].weight;
+            if (weight >= target || i + 1 == pieces.size()) {
+                chunks.emplace_back(start, i + 1);
+                start = i + 1;
+                weight = 0;
+            }
+        }
+
+        std::vector<parser::BufferedWriter> buffers(chunks.size());
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            while (true) {
+                size_t idx = next.fetch_add(1);
+                if (idx >= chunks.size()) break;
+                for (size_t i = chunks[idx].first; i < chunks[idx].second; ++i) {
+                    formatPiece<Style>(buffers[idx], pieces[i], width);
+                }
+            }
+        };
+
+        size_t workerCount = std::min<size_t>(jobs, chunks.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workerCount; ++i) threads.emplace_back(worker);
+        worker(); // 当前线程同样参与格式化
+        for (auto& t : threads) t.join();
+        for (auto& buffer : buffers) out.write(buffer.data(), buffer.size());
+    }
+
+#define FORMATTER_INSTANTIATE_PARALLEL(S, name) \
+    template void BasicFormatter<S>::formatParallel(parser::BufferedWriter&, parser::ASTNode*);
+    FORMATTER_STYLES(FORMATTER_INSTANTIATE_PARALLEL)
+#undef FORMATTER_INSTANTIATE_PARALLEL
+}
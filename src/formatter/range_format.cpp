@@ -0,0 +1,252 @@
+#include "formatter.h"
+#include "format_visitor.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace formatter {
+    using NT = parser::NodeType;
+
+    namespace {
+        // Token在源码中的字节区间和所在行
+        struct TokenExtent {
+            size_t begin;
+            size_t end;
+            int firstLine;
+            int lastLine;
+        };
+
+        // 一个替换单位：源码[begin, end)换成nodes按indent级缩进格式化的结果
+        struct Replacement {
+            size_t begin;
+            size_t end;
+            std::vector<parser::ASTNode*> nodes;
+            int indent;
+        };
+
+        class RangeFormatter {
+        public:
+            RangeFormatter(const std::string& src, std::vector<LineRange> ranges) : src(src), ranges(std::move(ranges)) {
+                lineStart.push_back(0); // 行号从1开始
+                lineStart.push_back(0);
+                for (size_t i = 0; i < src.size(); ++i) {
+                    if (src[i] == '\n') lineStart.push_back(i + 1);
+                }
+                std::sort(this->ranges.begin(), this->ranges.end(),
+                          [](const LineRange& a, const LineRange& b) { return a.first < b.first; });
+            }
+
+            int lastRequestedLine() const {
+                int last = 0;
+                for (const auto& r : ranges) last = std::max(last, r.last);
+                return last;
+            }
+
+            bool intersects(int first, int last) const {
+                for (const auto& r : ranges) {
+                    if (r.first <= last && r.last >= first) return true;
+                }
+                return false;
+            }
+
+            // 由行列号求出每个Token的字节区间，与源码对不上时返回false
+            bool mapTokens(const std::vector<lexer::Token>& tokens) {
+                extents.clear();
+                for (const auto& tk : tokens) {
+                    if (tk.line < 1 || tk.line >= (int)lineStart.size() || tk.column < 1) return false;
+                    size_t begin = lineStart[tk.line] + tk.column - 1;
+                    if (src.compare(begin, tk.text.size(), tk.text) != 0) return false;
+                    int lines = (int)std::count(tk.text.begin(), tk.text.end(), '\n');
+                    extents.push_back({begin, begin + tk.text.size(), tk.line, tk.line + lines});
+                }
+                return true;
+            }
+
+            size_t lineBegin(int line) const { return lineStart[line]; }
+            size_t lineEnd(int line) const { return line + 1 < (int)lineStart.size() ? lineStart[line + 1] : src.size(); }
+
+            // 节点独占若干整行时给出这些行的字节区间：首Token前和末Token后到行尾只有空白
+            bool ownedLines(const parser::ASTNode* node, int base, size_t& begin, size_t& end) const {
+                int first = node->firstToken - base;
+                int last = node->lastToken - base;
+                if (first < 0 || last < first || last >= (int)extents.size()) return false;
+                begin = lineBegin(extents[first].firstLine);
+                end = lineEnd(extents[last].lastLine);
+                for (size_t i = begin; i < extents[first].begin; ++i) {
+                    if (!std::isspace(static_cast<unsigned char>(src[i]))) return false;
+                }
+                for (size_t i = extents[last].end; i < end; ++i) {
+                    if (!std::isspace(static_cast<unsigned char>(src[i]))) return false;
+                }
+                return true;
+            }
+
+            int firstLine(const parser::ASTNode* node, int base) const { return extents[node->firstToken - base].firstLine; }
+            int lastLine(const parser::ASTNode* node, int base) const { return extents[node->lastToken - base].lastLine; }
+
+            // 与[first, last]相交的所需行都在复合语句的两个大括号之间（不含括号所在行）
+            bool insideBraces(const parser::ASTNode* block, int base, int first, int last) const {
+                int open = firstLine(block, base);
+                int close = lastLine(block, base);
+                for (const auto& r : ranges) {
+                    int lo = std::max(r.first, first);
+                    int hi = std::min(r.last, last);
+                    if (lo > hi) continue;
+                    if (lo <= open || hi >= close) return false;
+                }
+                return true;
+            }
+
+            // 在复合语句block中找出与所需行相交的最内层语句，depth为block内语句的缩进级数
+            // 某条语句不独占整行时返回false，由调用方退回到整个顶层声明
+            bool collect(parser::ASTNode* block, int base, int depth, std::vector<Replacement>& units) const {
+                for (auto* child : block->children) {
+                    if (!child) continue;
+                    bool list = child->type == NT::VarDeclList || child->type == NT::StmtList;
+                    std::vector<parser::ASTNode*> single{child};
+                    for (auto* item : list ? child->children : single) {
+                        if (!item || item->firstToken < 0) continue;
+                        int first = firstLine(item, base);
+                        int last = lastLine(item, base);
+                        if (!intersects(first, last)) continue;
+                        // 所需行都在某个语句体的大括号内时深入一层
+                        parser::ASTNode* inner = nullptr;
+                        if (item->type == NT::CompoundStmt) {
+                            if (insideBraces(item, base, first, last)) inner = item;
+                        } else {
+                            for (auto* sub : item->children) {
+                                if (sub && sub->type == NT::CompoundStmt && sub->firstToken >= 0 &&
+                                    insideBraces(sub, base, first, last)) {
+                                    inner = sub;
+                                    break;
+                                }
+                            }
+                        }
+                        if (inner) {
+                            if (!collect(inner, base, depth + 1, units)) return false;
+                            continue;
+                        }
+                        Replacement unit{0, 0, {item}, depth};
+                        if (!ownedLines(item, base, unit.begin, unit.end)) return false;
+                        units.push_back(std::move(unit));
+                    }
+                }
+                return true;
+            }
+
+        private:
+            const std::string& src;
+            std::vector<LineRange> ranges;
+            std::vector<size_t> lineStart; // 各行第一个字节的偏移
+            std::vector<TokenExtent> extents; // 当前一组顶层声明的Token位置
+        };
+    }
+
+    // 按行共享把顶层声明分组（如同一行上的两个声明、声明与行尾注释），一组独占若干整行
+    // 与所需行相交的组单独解析：函数定义内部的行只替换相交的最内层语句，否则整组重新格式化
+    template <class Style>
+    bool BasicFormatter<Style>::formatLines(const std::string& filename, const std::string& output,
+                                            std::vector<LineRange> lines, bool debug, bool flatChains, int width) {
+        std::string src;
+        FILE* input = fopen(filename.c_str(), "r");
+        if (!input || !readFile(filename, src)) {
+            if (input) fclose(input);
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            return false;
+        }
+        lexer::Lexer source(input);
+        std::string outFile = output;
+        if (outFile.empty()) outFile = "formatted.c";
+        FILE* out = fopen(outFile.c_str(), "w");
+        if (!out) {
+            std::cerr << "Cannot open output file: " << outFile << std::endl;
+            return false;
+        }
+
+        RangeFormatter ranges(src, std::move(lines));
+        parser::Parser parser(std::vector<lexer::Token>{}, debug);
+        parser.flatChains = flatChains;
+        bool ok = true;
+        size_t copied = 0;
+        parser::BufferedWriter writer(out);
+
+        std::vector<lexer::Token> group;
+        int groupBase = 0;
+        int groupFirst = 0;
+        int groupLast = 0;
+        auto flushGroup = [&]() {
+            if (group.empty() || !ranges.intersects(groupFirst, groupLast)) {
+                group.clear();
+                return;
+            }
+            if (!ranges.mapTokens(group)) {
+                std::cerr << "Cannot map tokens of lines " << groupFirst << "-" << groupLast
+                          << " to the source, left unchanged" << std::endl;
+                group.clear();
+                return;
+            }
+            std::vector<parser::ASTNode*> decls;
+            size_t errors = parser.diagnostics.size();
+            parser.parseChunk(std::move(group), groupBase, [&decls](parser::ASTNode* decl) { decls.push_back(decl); });
+            group.clear();
+            // 有语法错误的部分原样保留
+            if (parser.diagnostics.size() > errors) {
+                ok = false;
+                for (auto* decl : decls) delete decl;
+                return;
+            }
+            std::vector<Replacement> units;
+            auto* only = decls.size() == 1 ? decls[0] : nullptr;
+            bool inBody = only && only->type == NT::FunctionDef && only->children.size() > 3 &&
+                          only->children[3]->type == NT::CompoundStmt &&
+                          ranges.insideBraces(only->children[3], groupBase, groupFirst, groupLast);
+            if (!inBody || !ranges.collect(only->children[3], groupBase, 1, units)) {
+                units.clear();
+                units.push_back({ranges.lineBegin(groupFirst), ranges.lineEnd(groupLast), decls, 0});
+            }
+            for (const auto& unit : units) {
+                writer.write(src.data() + copied, unit.begin - copied);
+                parser::BufferedWriter formatted;
+                FormatVisitor<Style> visitor(formatted, unit.indent, width);
+                for (auto* node : unit.nodes) visitor.traverse(node);
+                writer.write(formatted.data(), formatted.size());
+                copied = unit.end;
+            }
+            for (auto* decl : decls) delete decl;
+        };
+
+        // 读到最后一个所需行之后就不再做词法分析，剩余部分直接复制
+        int lastLine = ranges.lastRequestedLine();
+        parser::TopLevelReader reader(source);
+        std::vector<lexer::Token> chunk;
+        while (reader.next(chunk)) {
+            int first = chunk.front().line;
+            const auto& tail = chunk.back();
+            int last = tail.line + (int)std::count(tail.text.begin(), tail.text.end(), '\n');
+            if (!group.empty() && first > groupLast) flushGroup();
+            if (group.empty()) {
+                if (first > lastLine) break;
+                groupBase = reader.chunkBegin();
+                groupFirst = first;
+                groupLast = last;
+            }
+            groupLast = std::max(groupLast, last);
+            for (auto& tk : chunk) group.push_back(std::move(tk));
+        }
+        flushGroup();
+        writer.write(src.data() + copied, src.size() - copied);
+        if (!writer.flush()) {
+            std::cerr << "Failed to write output file: " << outFile << std::endl;
+            ok = false;
+        }
+        fclose(out);
+        return ok;
+    }
+
+#define FORMATTER_INSTANTIATE_LINES(S, name) \
+    template bool BasicFormatter<S>::formatLines(const std::string&, const std::string&, std::vector<LineRange>, bool, bool, int);
+    FORMATTER_STYLES(FORMATTER_INSTANTIATE_LINES)
+#undef FORMATTER_INSTANTIATE_LINES
+}
@@ -0,0 +1,91 @@
+#ifndef STYLE_H
+#define STYLE_H
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "buffered_writer.h"
+
+namespace formatter {
+    // 格式风格策略，作为FormatVisitor、Layout和BasicFormatter的模板参数在编译期确定
+    // 各项都是编译期常量，输出路径上依风格的判断在编译时消除，每个风格各得一份特化代码
+    // - IndentWidth：每级缩进的列数，用制表符时为一个制表符折算的列数（计算折行宽度用）
+    // - Tabs：每级缩进输出一个制表符，否则输出IndentWidth个空格
+    // - Allman：控制语句的左大括号独占一行；否则按K&R风格接在语句头之后（函数体的左大括号两种风格都独占一行）
+    // - ParenSpaces：非空圆括号内侧各加一个空格，如 if ( x ) 和 f( a, b )
+    template <int IndentWidth, bool Tabs, bool Allman, bool ParenSpaces>
+    struct Style {
+        static constexpr int indentWidth = IndentWidth;
+        static constexpr bool allman = Allman;
+        static constexpr bool minify = false;
+
+        static void indent(parser::BufferedWriter& out, int level) {
+            if (level <= 0) return;
+            out.fill(Tabs ? '\t' : ' ', static_cast<size_t>(level) * (Tabs ? 1 : IndentWidth));
+        }
+        static const std::string& indentUnit() {
+            static const std::string unit = Tabs ? std::string(1, '\t') : std::string(IndentWidth, ' ');
+            return unit;
+        }
+        static const char* openParen() { return ParenSpaces ? "( " : "("; }
+        static const char* closeParen() { return ParenSpaces ? " )" : ")"; }
+    };
+
+    using AllmanStyle = Style<4, false, true, false>; // 默认风格
+    using KRStyle = Style<4, false, false, false>;
+    using LinuxStyle = Style<8, true, false, false>;
+    using CompactStyle = Style<2, false, false, false>;
+    using PaddedStyle = Style<4, false, true, true>;
+    // 压缩输出：去掉注释、缩进和换行，Token之间只在相连会改变词法分析结果时留一个空格；不折行
+    struct MinifyStyle : Style<4, false, true, false> {
+        static constexpr bool minify = true;
+    };
+
+    // 预置风格的类型和名字，新增风格只需在此添加一项；X对每个风格展开一次（用于显式实例化等）
+#define FORMATTER_STYLES(X) \
+    X(AllmanStyle, "allman") \
+    X(KRStyle, "kr") \
+    X(LinuxStyle, "linux") \
+    X(CompactStyle, "compact") \
+    X(PaddedStyle, "padded") \
+    X(MinifyStyle, "minify")
+
+    inline std::vector<std::string> styleNames() {
+#define FORMATTER_STYLE_NAME(S, name) name,
+        return {FORMATTER_STYLES(FORMATTER_STYLE_NAME)};
+#undef FORMATTER_STYLE_NAME
+    }
+
+    // 预置风格的编号，与FORMATTER_STYLES的顺序一致，也用于格式化结果缓存的键
+    enum class StyleId : unsigned {
+#define FORMATTER_STYLE_ID(S, name) S,
+        FORMATTER_STYLES(FORMATTER_STYLE_ID)
+#undef FORMATTER_STYLE_ID
+    };
+
+    // 按名字查预置风格，名字不在styleNames中时返回false；命令行在启动时调用一次，之后只传StyleId
+    inline bool parseStyle(const std::string& name, StyleId& id) {
+#define FORMATTER_STYLE_LOOKUP(S, styleName) \
+        if (name == styleName) { \
+            id = StyleId::S; \
+            return true; \
+        }
+        FORMATTER_STYLES(FORMATTER_STYLE_LOOKUP)
+#undef FORMATTER_STYLE_LOOKUP
+        return false;
+    }
+
+    // 以id对应风格类型的一个值调用f（可用泛型lambda），返回f的结果；
+    // 选择只在启动时做一次，此后整条格式化路径都是该风格的特化代码
+    template <class F>
+    auto withStyle(StyleId id, F&& f) -> decltype(f(AllmanStyle{})) {
+        switch (id) {
+#define FORMATTER_STYLE_CASE(S, name) \
+            case StyleId::S: return f(S{});
+            FORMATTER_STYLES(FORMATTER_STYLE_CASE)
+#undef FORMATTER_STYLE_CASE
+        }
+        std::abort(); // StyleId只能来自parseStyle，各值都已在上面处理
+    }
+}
+
+#endif //STYLE_H
@@ -0,0 +1,60 @@
+#include "token_verify.h"
+#include "formatter.h"
+#include "token_translater.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace formatter {
+    // 两边各扫一批再比较：交替逐个扫描时两个扫描器的状态在缓存和分支预测上互相干扰，速度只有一半
+    bool sameTokens(const char* aData, size_t aSize, const char* bData, size_t bSize, lexer::TokenSpan& a,
+                    lexer::TokenSpan& b) {
+        const size_t batch = 256;
+        lexer::TokenSpan aSpans[batch];
+        lexer::TokenSpan bSpans[batch];
+        lexer::SpanScanner sa(aData, aSize);
+        lexer::SpanScanner sb(bData, bSize);
+        bool aEnd = false;
+        bool bEnd = false;
+        for (;;) {
+            size_t an = 0;
+            size_t bn = 0;
+            while (an < batch && !aEnd) aEnd = (aSpans[an++] = sa.next()).kind == lexer::TokenKind::EOF_TOKEN;
+            while (bn < batch && !bEnd) bEnd = (bSpans[bn++] = sb.next()).kind == lexer::TokenKind::EOF_TOKEN;
+            // 一方先结束时它的一批以EOF_TOKEN结尾，比较在此处或之前停下
+            size_t n = std::min(an, bn);
+            for (size_t i = 0; i < n; ++i) {
+                a = aSpans[i];
+                b = bSpans[i];
+                if (a.kind != b.kind || a.length != b.length ||
+                    memcmp(aData + a.offset, bData + b.offset, a.length) != 0) {
+                    return false;
+                }
+                if (a.kind == lexer::TokenKind::EOF_TOKEN) return true;
+            }
+        }
+    }
+
+    bool verifyTokens(const std::string& input, const std::string& output) {
+        std::string source;
+        std::string formatted;
+        if (!readFile(input, source) || !readFile(output, formatted)) {
+            std::cerr << "Cannot read files to verify: " << input << ", " << output << std::endl;
+            return false;
+        }
+        lexer::TokenSpan a{};
+        lexer::TokenSpan b{};
+        if (sameTokens(source.data(), source.size(), formatted.data(), formatted.size(), a, b)) return true;
+        int aLine, aColumn, bLine, bColumn;
+        lexer::position(source.data(), a.offset, aLine, aColumn);
+        lexer::position(formatted.data(), b.offset, bLine, bColumn);
+        auto describe = [](const std::string& data, const lexer::TokenSpan& span) {
+            return lexer::TokenKindToString(span.kind) + " '" +
+                   data.substr(span.offset, std::min<size_t>(span.length, 40)) + "'";
+        };
+        std::cerr << "Verification failed: " << input << ":" << aLine << ":" << aColumn << " has "
+                  << describe(source, a) << " but " << output << ":" << bLine << ":" << bColumn << " has "
+                  << describe(formatted, b) << std::endl;
+        return false;
+    }
+}
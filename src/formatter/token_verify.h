@@ -0,0 +1,17 @@
+#ifndef TOKEN_VERIFY_H
+#define TOKEN_VERIFY_H
+#include <cstddef>
+#include <string>
+#include "span_scanner.h"
+
+namespace formatter {
+    // 逐个比较两段源码去掉空白和注释后的Token序列（种类和文本），一趟线性扫描，不构造字符串；
+    // 相同时返回true，否则a、b为第一处不同的Token（其中一方先结束时为其EOF_TOKEN）
+    bool sameTokens(const char* aData, size_t aSize, const char* bData, size_t bSize, lexer::TokenSpan& a,
+                    lexer::TokenSpan& b);
+
+    // 校验格式化结果：output与input的Token序列须相同，不同时把第一处不同的位置和Token写到标准错误
+    bool verifyTokens(const std::string& input, const std::string& output);
+}
+
+#endif //TOKEN_VERIFY_H
@@ -0,0 +1,182 @@
+#include "formatter.h"
+#include "format_visitor.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace formatter {
+    namespace {
+        bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+        // 源码中两个Token之间的一段trivia含注释时，与格式化结果中对应的空白合成输出：
+        // - 源码中另起一行的注释仍另起一行，缩进为indent；与前面内容同行的注释仍跟在同一行
+        // - 注释前后的空行最多保留一个
+        // - 注释之后源码换了行（或是行注释）时下一个Token另起一行：格式化结果在此换行就用它的空白，否则按contIndent续行
+        // - 注释之后不换行时，源码或格式化结果有一个在此留了空格，注释后就留一个空格
+        void mergeComments(const char* s, size_t sn, const char* g, size_t gn, const std::string& indent,
+                           const std::string& contIndent, bool atStart, std::string& out) {
+            out.clear();
+            int newlines = 0;
+            bool space = false;
+            bool lineComment = false;
+            size_t i = 0;
+            while (i < sn) {
+                if (isBlank(s[i])) {
+                    if (s[i] == '\n') ++newlines;
+                    space = true;
+                    ++i;
+                    continue;
+                }
+                // 词法分析已保证这里是完整的注释
+                size_t end = i + 2;
+                lineComment = s[i + 1] == '/';
+                if (lineComment) {
+                    while (end < sn && s[end] != '\n') ++end;
+                } else {
+                    while (end + 1 < sn && !(s[end] == '*' && s[end + 1] == '/')) ++end;
+                    end += 2;
+                }
+                if (atStart && out.empty()) {
+                    // 文件开头的注释前不加空白
+                } else if (newlines > 0) {
+                    out += newlines > 1 ? "\n\n" : "\n";
+                    out += indent;
+                } else if (space) {
+                    out += ' ';
+                }
+                out.append(s + i, end - i);
+                newlines = 0;
+                space = false;
+                i = end;
+            }
+            bool gBreak = memchr(g, '\n', gn) != nullptr;
+            if (newlines > 0 || lineComment) {
+                if (gBreak) {
+                    if (newlines > 1 && std::count(g, g + gn, '\n') == 1) out += '\n';
+                    out.append(g, gn);
+                } else {
+                    out += '\n';
+                    out += contIndent;
+                }
+            } else if (gBreak) {
+                out.append(g, gn);
+            } else if (space || gn > 0) {
+                // 源码中注释紧贴下一个Token时，格式化结果在此处的空格仍然保留
+                out += ' ';
+            }
+        }
+
+        // 一处空白修改：源码[begin, end)换成text
+        struct WhitespaceEdit {
+            size_t begin;
+            size_t end;
+            const char* text;
+            size_t size;
+        };
+
+        // 格式化结果中pos所在行的行首缩进；atLineStart给出pos之前是否只有缩进
+        std::string lineIndent(const char* f, size_t pos, bool& atLineStart) {
+            size_t begin = pos;
+            while (begin > 0 && f[begin - 1] != '\n') --begin;
+            size_t end = begin;
+            while (end < pos && (f[end] == ' ' || f[end] == '\t')) ++end;
+            atLineStart = end == pos;
+            return std::string(f + begin, end - begin);
+        }
+    }
+
+    // 保留trivia的格式化：词法分析把注释和空白记在Token上，语法分析和格式化只看到代码Token；
+    // 再把格式化结果与源码逐个Token对齐，Token文本必然相同，只有相邻Token间的空白可能不同：
+    // 空白相同的连续部分直接从源码整段复制，不同处写出格式化结果的空白，含注释处合成两者（见mergeComments）
+    template <class Style>
+    bool BasicFormatter<Style>::formatTrivia(const std::string& filename, const std::string& output, bool debug,
+                                             bool flatChains, int width) {
+        std::string src;
+        FILE* input = fopen(filename.c_str(), "r");
+        if (!input || !readFile(filename, src)) {
+            if (input) fclose(input);
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            return false;
+        }
+        lexer::Lexer source(input, true);
+        parser::Parser parser(source, debug);
+        parser.flatChains = flatChains;
+        parser::ASTNode* root = parser.parse();
+        if (!parser.diagnostics.empty()) return false;
+        parser::BufferedWriter formatted(nullptr, src.size() + src.size() / 2 + 4096);
+        FormatVisitor<Style>(formatted, 0, width).traverse(root);
+
+        // 先对齐全部Token得到修改列表，确认无误后再写文件
+        const char* f = formatted.data();
+        const size_t fn = formatted.size();
+        size_t fp = 0;
+        size_t prevEnd = 0;        // 上一个Token在源码中的结束位置
+        uint32_t prevTrailing = 0; // 上一个Token的尾随trivia
+        std::vector<WhitespaceEdit> edits;
+        std::deque<std::string> merged; // 含注释处合成的空白，deque中的字符串地址不变
+        for (const auto& tk : parser.tokenList()) {
+            size_t gapBegin = fp;
+            while (fp < fn && isBlank(f[fp])) ++fp;
+            bool same = tk.kind == lexer::TokenKind::EOF_TOKEN
+                            ? fp == fn
+                            : fn - fp >= tk.text.size() && memcmp(f + fp, tk.text.data(), tk.text.size()) == 0 &&
+                              src.compare(tk.offset, tk.text.size(), tk.text) == 0;
+            // 上一个Token的尾随trivia与本Token的前导trivia恰好拼满两者之间
+            same = same && prevEnd + prevTrailing + tk.leading == tk.offset;
+            if (!same) {
+                std::cerr << "Formatted tokens differ from the source at line " << tk.line << ", column " << tk.column
+                          << "; nothing written" << std::endl;
+                return false;
+            }
+            const char* s = src.data() + prevEnd;
+            size_t sn = prevTrailing + tk.leading;
+            WhitespaceEdit edit{prevEnd, tk.offset, f + gapBegin, fp - gapBegin};
+            if (memchr(s, '/', sn)) {
+                bool atLineStart;
+                std::string next = lineIndent(f, fp, atLineStart);
+                // 格式化结果中Token在行中间时，插到它前面的换行按续行多缩进一级
+                std::string indent = atLineStart ? next : next + Style::indentUnit();
+                std::string contIndent = indent;
+                // 右大括号前独占一行的注释属于块内，多缩进一级
+                if (atLineStart && tk.kind == lexer::TokenKind::RC) indent += Style::indentUnit();
+                merged.emplace_back();
+                mergeComments(s, sn, edit.text, edit.size, indent, contIndent, prevEnd == 0, merged.back());
+                edit.text = merged.back().data();
+                edit.size = merged.back().size();
+            }
+            if (edit.size != sn || memcmp(edit.text, s, sn) != 0) edits.push_back(edit);
+            fp += tk.text.size();
+            prevEnd = tk.offset + tk.text.size();
+            prevTrailing = tk.trailing;
+        }
+
+        std::string outFile = output;
+        if (outFile.empty()) outFile = "formatted.c";
+        FILE* out = fopen(outFile.c_str(), "w");
+        if (!out) {
+            std::cerr << "Cannot open output file: " << outFile << std::endl;
+            return false;
+        }
+        // 修改之间的部分整段从源码复制；已格式化的文件没有修改，整个输出就是一次复制
+        parser::BufferedWriter writer(out, src.size() + 4096);
+        size_t copied = 0;
+        for (const auto& edit : edits) {
+            writer.write(src.data() + copied, edit.begin - copied);
+            writer.write(edit.text, edit.size);
+            copied = edit.end;
+        }
+        writer.write(src.data() + copied, src.size() - copied);
+        bool ok = writer.flush();
+        if (!ok) std::cerr << "Failed to write output file: " << outFile << std::endl;
+        fclose(out);
+        return ok;
+    }
+
+#define FORMATTER_INSTANTIATE_TRIVIA(S, name) \
+    template bool BasicFormatter<S>::formatTrivia(const std::string&, const std::string&, bool, bool, int);
+    FORMATTER_STYLES(FORMATTER_INSTANTIATE_TRIVIA)
+#undef FORMATTER_INSTANTIATE_TRIVIA
+}
@@ -7,16 +7,20 @@
 #include <algorithm>
 
 namespace lexer {
-    Lexer::Lexer(FILE *file) : file(file), line(1),column(0) {
+    Lexer::Lexer(FILE *file, bool trivia) : file(file), line(1), column(0), trivia(trivia) {
         if (!file) {
             throw std::runtime_error("Failed to open file");
         }
     }
+    Lexer::Lexer(const char* data, size_t size, size_t offset, int line, int column) :
+        file(nullptr), data(data), size(size), line(line), column(column), pos(offset) {}
+    Lexer::Lexer() : file(nullptr), line(1), column(0) {}
     Lexer::~Lexer() {
         if (file) fclose(file);
     }
 
     std::vector<Token> Lexer::tokenize() {
+        if (!file && !data) return tokens_cache;
         tokens_cache.clear();
         Token token;
         do {
@@ -26,64 +30,117 @@ namespace lexer {
         return tokens_cache;
     }
 
-    void Lexer::printTokensOrder() {
+    Token Lexer::next() {
+        if (!file && !data) return makeToken(TokenKind::EOF_TOKEN, "");
+        return getToken();
+    }
+
+    void Lexer::printTokensOrder(std::ostream& out) {
         if (tokens_cache.empty()) tokenize();
         for (const auto& token : tokens_cache) {
-            token.print();
+            token.print(out);
         }
     }
 
-    void Lexer::printTokensSorted() {
+    void Lexer::printTokensSorted(std::ostream& out) {
         if (tokens_cache.empty()) tokenize();
         std::vector<Token> sorted_tokens = tokens_cache;
         std::sort(sorted_tokens.begin(), sorted_tokens.end(), [](const Token& a, const Token& b) {
             return static_cast<int>(a.kind) < static_cast<int>(b.kind);
         });
         for (const auto& token : sorted_tokens) {
-            token.print();
+            token.print(out);
         }
     }
 
-    void Lexer::printTokensOrderPretty() {
+    void Lexer::printTokensOrderPretty(std::ostream& out) {
         if (tokens_cache.empty()) tokenize();
         for (const auto& token : tokens_cache) {
-            std::cout << "Token(" << TokenKindToString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
+            out << "Token(" << TokenKindToString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
         }
     }
 
-    void Lexer::printTokensSortedPretty() {
+    void Lexer::printTokensSortedPretty(std::ostream& out) {
         if (tokens_cache.empty()) tokenize();
         std::vector<Token> sorted_tokens = tokens_cache;
         std::sort(sorted_tokens.begin(), sorted_tokens.end(), [](const Token& a, const Token& b) {
             return static_cast<int>(a.kind) < static_cast<int>(b.kind);
         });
         for (const auto& token : sorted_tokens) {
-            std::cout << "Token(" << TokenKindToString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
+            out << "Token(" << TokenKindToString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
         }
     }
 
-    void Lexer::printTokensOrderCN() {
+    void Lexer::printTokensOrderCN(std::ostream& out) {
         if (tokens_cache.empty()) tokenize();
         for (const auto& token : tokens_cache) {
-            std::cout << "Token(" << TokenKindToCNString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
+            out << "Token(" << TokenKindToCNString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
         }
     }
 
-    void Lexer::printTokensSortedCN() {
+    void Lexer::printTokensSortedCN(std::ostream& out) {
         if (tokens_cache.empty()) tokenize();
         std::vector<Token> sorted_tokens = tokens_cache;
         std::sort(sorted_tokens.begin(), sorted_tokens.end(), [](const Token& a, const Token& b) {
             return static_cast<int>(a.kind) < static_cast<int>(b.kind);
         });
         for (const auto& token : sorted_tokens) {
-            std::cout << "Token(" << TokenKindToCNString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
+            out << "Token(" << TokenKindToCNString(token.kind) << ", \"" << token.text << "\", " << token.line << ", " << token.column << ")\n";
         }
     }
 
     Token Lexer::getToken() {
+        if (!trivia) return scanToken();
+        if (hasPending) {
+            hasPending = false;
+            return pending;
+        }
+        size_t start = pos;
+        Token token = scanToken();
+        while (token.kind == TokenKind::LINE_COMMENT || token.kind == TokenKind::BLOCK_COMMENT) token = scanToken();
+        token.leading = static_cast<uint32_t>(token.offset - start);
+        if (token.kind != TokenKind::EOF_TOKEN && token.kind != TokenKind::ERROR_TOKEN) scanTrailing(token);
+        return token;
+    }
+
+    // 读入Token之后同一行的空白和注释，到换行符（含）为止；跨行的块注释只要在本行开始就算作尾随
+    void Lexer::scanTrailing(Token& token) {
+        size_t start = pos;
+        for (;;) {
+            int c = get();
+            if (c == '\n') {
+                line++;
+                column = 0;
+                break;
+            }
+            if (c != EOF && std::isspace(c)) {
+                column++;
+                continue;
+            }
+            if (c == '/') {
+                int next = get();
+                unget(next);
+                unget(c);
+                if (next != '/' && next != '*') break;
+                Token comment = scanToken();
+                if (comment.kind == TokenKind::ERROR_TOKEN) {
+                    pending = comment;
+                    hasPending = true;
+                    break;
+                }
+                if (comment.kind == TokenKind::LINE_COMMENT) break; // 行注释已读入行尾的换行符
+                continue;
+            }
+            unget(c);
+            break;
+        }
+        token.trailing = static_cast<uint32_t>(pos - start);
+    }
+
+    Token Lexer::scanToken() {
         int c;
         // 跳过空白符并记录行列号
-        while ((c = fgetc(file)) != EOF && std::isspace(c)) {
+        while ((c = get()) != EOF && std::isspace(c)) {
             if (c == '\n') {
                 line++;
                 column = 0;
@@ -91,22 +148,24 @@ namespace lexer {
                 column++;
             }
         }
+        tokenStart = c == EOF ? pos : pos - 1;
         if (c == EOF) {
             return makeToken(TokenKind::EOF_TOKEN, "");
         }
 
         int start_col = column + 1; // 当前字符是第几个字符
+        int start_line = line;      // 注释可能跨行，记录起始行号
         std::string text;
 
         // 标识符或关键字
         if (std::isalpha(c) || c == '_') {
             text += static_cast<char>(c);
             column++;
-            while ((c = fgetc(file)), (std::isalnum(c) || c == '_')) {
+            while ((c = get()), (std::isalnum(c) || c == '_')) {
                 text += static_cast<char>(c);
                 column++;
             }
-            if (c != EOF) ungetc(c, file);
+            if (c != EOF) unget(c);
 
             // 判断是否为关键字
 
@@ -125,7 +184,7 @@ namespace lexer {
             bool isHex = false, isOct = false, isFloat = false;
             int base = 10;
             int firstChar = c;
-            c = fgetc(file);
+            c = get();
             if (firstChar == '0') {
                 if (c == 'x' || c == 'X') {
                     text += static_cast<char>(c);
@@ -133,7 +192,7 @@ namespace lexer {
                     isHex = true;
                     base = 16;
                     // 读取十六进制数字
-                    while ((c = fgetc(file)), std::isxdigit(c)) {
+                    while ((c = get()), std::isxdigit(c)) {
                         text += static_cast<char>(c);
                         column++;
                     }
@@ -144,7 +203,7 @@ namespace lexer {
                     while (std::isdigit(c)) {
                         text += static_cast<char>(c);
                         column++;
-                        c = fgetc(file);
+                        c = get();
                     }
                 }
             }
@@ -157,7 +216,7 @@ namespace lexer {
                     }
                     text += static_cast<char>(c);
                     column++;
-                    c = fgetc(file);
+                    c = get();
                 }
             }
             // 检查是否为long整型常量（如123L）
@@ -166,7 +225,7 @@ namespace lexer {
                 column++;
                 return makeToken(TokenKind::LONG_CONST, text, start_col);
             }
-            if (c != EOF) ungetc(c, file);
+            if (c != EOF) unget(c);
             if (isFloat)
                 return makeToken(TokenKind::FLOAT_CONST, text, start_col);
             else if (isHex || isOct)
@@ -179,11 +238,11 @@ namespace lexer {
         if (c == '"') {
             text += static_cast<char>(c);
             column++;
-            while ((c = fgetc(file)) != EOF && c != '"') {
+            while ((c = get()) != EOF && c != '"') {
                 if (c == '\\') { // 处理转义字符
                     text += static_cast<char>(c);
                     column++;
-                    c = fgetc(file);
+                    c = get();
                     if (c == EOF) break;
                 }
                 text += static_cast<char>(c);
@@ -200,37 +259,38 @@ namespace lexer {
 
         // 注释处理
         if (c == '/') {
-            int next = fgetc(file);
+            int next = get();
             if (next == '/') {
                 // 行注释 //
                 text = "//";
                 column += 2;
-                while ((c = fgetc(file)) != EOF && c != '\n') {
+                while ((c = get()) != EOF && c != '\n') {
                     text += static_cast<char>(c);
                     column++;
                 }
+                Token token = makeToken(TokenKind::LINE_COMMENT, text, start_col);
                 if (c == '\n') {
                     line++;
                     column = 0;
                 }
-                return makeToken(TokenKind::LINE_COMMENT, text, start_col);
+                return token;
             } else if (next == '*') {
                 // 块注释 /**/
                 text = "/*";
                 column += 2;
                 bool endFound = false;
-                while ((c = fgetc(file)) != EOF) {
+                while ((c = get()) != EOF) {
                     text += static_cast<char>(c);
                     column++;
                     if (c == '*') {
-                        int peek = fgetc(file);
+                        int peek = get();
                         if (peek == '/') {
                             text += '/';
                             column++;
                             endFound = true;
                             break;
                         } else if (peek != EOF) {
-                            ungetc(peek, file);
+                            unget(peek);
                         }
                     }
                     if (c == '\n') {
@@ -241,9 +301,11 @@ namespace lexer {
                 if (!endFound) {
                     return makeToken(TokenKind::ERROR_TOKEN, text, start_col);
                 }
-                return makeToken(TokenKind::BLOCK_COMMENT, text, start_col);
+                Token token = makeToken(TokenKind::BLOCK_COMMENT, text, start_col);
+                token.line = start_line;
+                return token;
             } else {
-                if (next != EOF) ungetc(next, file);
+                if (next != EOF) unget(next);
                 return makeToken(TokenKind::DIV, "/", start_col);
             }
         }
@@ -252,62 +314,62 @@ namespace lexer {
         column++;
         switch (c) {
             case '=': {
-                int next = fgetc(file);
+                int next = get();
                 if (next == '=') {
                     column++;
                     return makeToken(TokenKind::EQ, "==", start_col);
                 } else {
-                    if (next != EOF) ungetc(next, file);
+                    if (next != EOF) unget(next);
                     return makeToken(TokenKind::ASSIGN, "=", start_col);
                 }
             }
             case '!': {
-                int next = fgetc(file);
+                int next = get();
                 if (next == '=') {
                     column++;
                     return makeToken(TokenKind::NEQ, "!=", start_col);
                 } else {
-                    if (next != EOF) ungetc(next, file);
+                    if (next != EOF) unget(next);
                     return makeToken(TokenKind::NOT, "!", start_col);
                 }
             }
             case '&': {
-                int next = fgetc(file);
+                int next = get();
                 if (next == '&') {
                     column++;
                     return makeToken(TokenKind::AND, "&&", start_col);
                 } else {
-                    if (next != EOF) ungetc(next, file);
+                    if (next != EOF) unget(next);
                     return makeToken(TokenKind::ERROR_TOKEN, "&", start_col);
                 }
             }
             case '|': {
-                int next = fgetc(file);
+                int next = get();
                 if (next == '|') {
                     column++;
                     return makeToken(TokenKind::OR, "||", start_col);
                 } else {
-                    if (next != EOF) ungetc(next, file);
+                    if (next != EOF) unget(next);
                     return makeToken(TokenKind::ERROR_TOKEN, "|", start_col);
                 }
             }
             case '<': {
-                int next = fgetc(file);
+                int next = get();
                 if (next == '=') {
                     column++;
                     return makeToken(TokenKind::LE, "<=", start_col);
                 } else {
-                    if (next != EOF) ungetc(next, file);
+                    if (next != EOF) unget(next);
                     return makeToken(TokenKind::LT, "<", start_col);
                 }
             }
             case '>': {
-                int next = fgetc(file);
+                int next = get();
                 if (next == '=') {
                     column++;
                     return makeToken(TokenKind::GE, ">=", start_col);
                 } else {
-                    if (next != EOF) ungetc(next, file);
+                    if (next != EOF) unget(next);
                     return makeToken(TokenKind::GT, ">", start_col);
                 }
             }
@@ -330,6 +392,8 @@ namespace lexer {
     }
 
     Token Lexer::makeToken(TokenKind kind, const std::string& text, int col) const {
-        return Token{kind, text, line, col ? col : column};
+        Token token{kind, text, line, col ? col : column};
+        token.offset = tokenStart;
+        return token;
     }
 }
@@ -1,6 +1,7 @@
 #ifndef LEXER_H
 #define LEXER_H
 #pragma once
+#include <iostream>
 #include <string>
 #include <vector>
 #include "token.h"
@@ -8,21 +9,53 @@
 namespace lexer {
     class Lexer {
     public:
-        explicit Lexer(FILE *file);
-        ~Lexer();
+        // trivia为真时注释不作为Token返回，而是与空白一起记为相邻Token的前导或尾随trivia
+        explicit Lexer(FILE *file, bool trivia = false);
+        // 在内存缓冲区上做词法分析，缓冲区须在Lexer之前一直有效；从offset处开始，
+        // line和column为offset处的行号和该行已读的字符数，用于从某个Token起点接着分析
+        Lexer(const char* data, size_t size, size_t offset = 0, int line = 1, int column = 0);
+        Lexer(); // 不关联文件，用于由已有Token序列构造的Parser
+        ~Lexer(); // 关闭构造时传入的文件
+        // 独占所持有的文件，不可复制
+        Lexer(const Lexer&) = delete;
+        Lexer& operator=(const Lexer&) = delete;
         std::vector<Token> tokenize();
-        void printTokensOrder(); // 顺序输出
-        void printTokensSorted(); // 按种类编码排序输出
-        void printTokensOrderPretty(); // 顺序美化输出
-        void printTokensSortedPretty(); // 排序美化输出
-        void printTokensOrderCN(); // 顺序中文输出
-        void printTokensSortedCN(); // 排序中文输出
+        // 以下输出已读入的全部Token（尚未读入时先做词法分析），默认输出到标准输出
+        Token next(); // 逐个读取下一个Token，不进入缓存，用于流式解析
+        void printTokensOrder(std::ostream& out = std::cout); // 顺序输出
+        void printTokensSorted(std::ostream& out = std::cout); // 按种类编码排序输出
+        void printTokensOrderPretty(std::ostream& out = std::cout); // 顺序美化输出
+        void printTokensSortedPretty(std::ostream& out = std::cout); // 排序美化输出
+        void printTokensOrderCN(std::ostream& out = std::cout); // 顺序中文输出
+        void printTokensSortedCN(std::ostream& out = std::cout); // 排序中文输出
     private:
         FILE *file;
+        const char* data = nullptr; // 内存缓冲区，非空时不读file
+        size_t size = 0;
         int line;
         int column;
+        bool trivia = false;
+        size_t pos = 0;        // 已读入的字节数（内存缓冲区上为当前偏移）
+        size_t tokenStart = 0; // 当前Token的起始字节偏移
+        char pushback[4];      // 退回的字符，ungetc只保证一个
+        int pushed = 0;
+        bool hasPending = false; // 尾随trivia中遇到未闭合的块注释时，留待下次返回的错误Token
+        Token pending;
         std::vector<Token> tokens_cache; // 缓存token列表
         Token getToken();
+        Token scanToken();
+        void scanTrailing(Token& token);
+        int get() {
+            if (data) return pos < size ? static_cast<unsigned char>(data[pos++]) : EOF;
+            int c = pushed ? static_cast<unsigned char>(pushback[--pushed]) : fgetc(file);
+            if (c != EOF) ++pos;
+            return c;
+        }
+        void unget(int c) {
+            if (c == EOF) return;
+            if (!data) pushback[pushed++] = static_cast<char>(c);
+            --pos;
+        }
         Token makeToken(TokenKind kind, const std::string& text, int col = 0) const;
     };
 }
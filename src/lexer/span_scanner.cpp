@@ -0,0 +1,169 @@
+#include "span_scanner.h"
+#include <cctype>
+#include <cstring>
+
+namespace lexer {
+    namespace {
+        struct Keyword {
+            const char* text;
+            size_t length;
+            TokenKind kind;
+        };
+        const Keyword keywordTable[] = {
+            {"int", 3, TokenKind::INT},         {"float", 5, TokenKind::FLOAT},
+            {"char", 4, TokenKind::CHAR},       {"long", 4, TokenKind::LONG},
+            {"void", 4, TokenKind::VOID},       {"if", 2, TokenKind::IF},
+            {"else", 4, TokenKind::ELSE},       {"while", 5, TokenKind::WHILE},
+            {"for", 3, TokenKind::FOR},         {"return", 6, TokenKind::RETURN},
+            {"continue", 8, TokenKind::CONTINUE}, {"break", 5, TokenKind::BREAK},
+        };
+
+        // 与keywords表相同，直接在缓冲区上比较；关键字长2到8，绝大多数标识符不必逐个比较
+        TokenKind identifierKind(const char* s, size_t n) {
+            if (n < 2 || n > 8 || s[0] < 'b' || s[0] > 'w') return TokenKind::IDENT;
+            for (const auto& kw : keywordTable) {
+                if (kw.length == n && kw.text[0] == s[0] && memcmp(kw.text, s, n) == 0) return kw.kind;
+            }
+            return TokenKind::IDENT;
+        }
+
+        // 字符分类表，与C locale下的isspace、isalpha、isdigit一致；kind为单字符运算符和定界符的种类
+        enum CharClass : unsigned char { Other = 0, Space = 1, Alpha = 2, Digit = 4 };
+        struct CharTable {
+            unsigned char cls[256];
+            TokenKind kind[256];
+            CharTable() {
+                for (int c = 0; c < 256; ++c) {
+                    cls[c] = Other;
+                    if (c == ' ' || (c >= '\t' && c <= '\r')) cls[c] = Space;
+                    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') cls[c] = Alpha;
+                    if (c >= '0' && c <= '9') cls[c] = Digit;
+                    kind[c] = TokenKind::ERROR_TOKEN;
+                }
+                const char* chars = "=!<>+-*/%()[]{};,";
+                const TokenKind kinds[] = {TokenKind::ASSIGN, TokenKind::NOT,  TokenKind::LT,   TokenKind::GT,
+                                           TokenKind::PLUS,   TokenKind::MINUS, TokenKind::MUL, TokenKind::DIV,
+                                           TokenKind::MOD,    TokenKind::LP,   TokenKind::RP,   TokenKind::LB,
+                                           TokenKind::RB,     TokenKind::LC,   TokenKind::RC,   TokenKind::SEMI,
+                                           TokenKind::COMMA};
+                for (size_t i = 0; chars[i]; ++i) kind[static_cast<unsigned char>(chars[i])] = kinds[i];
+            }
+        };
+        const CharTable charTable;
+
+        inline bool isSpace(int c) { return c >= 0 && charTable.cls[c] == Space; }
+        inline bool isIdentChar(int c) { return c >= 0 && (charTable.cls[c] & (Alpha | Digit)); }
+    }
+
+    bool SpanScanner::skipTrivia() {
+        while (pos < size) {
+            int c = peek(pos);
+            if (isSpace(c)) {
+                ++pos;
+            } else if (c == '/' && peek(pos + 1) == '/') {
+                const void* eol = memchr(data + pos, '\n', size - pos);
+                pos = eol ? static_cast<const char*>(eol) - data + 1 : size;
+            } else if (c == '/' && peek(pos + 1) == '*') {
+                size_t i = pos + 2;
+                while (i + 1 < size && !(data[i] == '*' && data[i + 1] == '/')) ++i;
+                if (i + 1 >= size) return false; // pos停在注释开头
+                pos = i + 2;
+            } else {
+                break;
+            }
+        }
+        return true;
+    }
+
+    // 规则同Lexer::scanToken中的数字常量：十六进制、八进制、十进制或带一个小数点的浮点数，可带L后缀
+    size_t SpanScanner::scanNumber(size_t at, TokenKind& kind) const {
+        size_t i = at + 1;
+        bool isHex = false, isOct = false, isFloat = false;
+        int c = peek(i);
+        if (data[at] == '0') {
+            if (c == 'x' || c == 'X') {
+                isHex = true;
+                ++i;
+                while (std::isxdigit(peek(i))) ++i;
+            } else if (std::isdigit(c)) {
+                isOct = true;
+                while (std::isdigit(peek(i))) ++i;
+            }
+        }
+        if (!isHex && !isOct) {
+            while (std::isdigit(c = peek(i)) || c == '.') {
+                if (c == '.') {
+                    if (isFloat) break; // 第二个点不属于本Token
+                    isFloat = true;
+                }
+                ++i;
+            }
+        }
+        c = peek(i);
+        if (c == 'L' || c == 'l') {
+            kind = TokenKind::LONG_CONST;
+            return i + 1 - at;
+        }
+        kind = isFloat ? TokenKind::FLOAT_CONST : TokenKind::INT_CONST;
+        return i - at;
+    }
+
+    TokenSpan SpanScanner::next() {
+        if (!skipTrivia()) {
+            // 未闭合的块注释吞掉其后全部内容
+            size_t start = pos;
+            pos = size;
+            return {TokenKind::ERROR_TOKEN, start, size - start};
+        }
+        size_t start = pos;
+        if (pos >= size) return {TokenKind::EOF_TOKEN, size, 0};
+        int c = peek(pos);
+        TokenKind kind = TokenKind::ERROR_TOKEN;
+        size_t length = 1;
+        if (c >= 0 && charTable.cls[c] == Alpha) {
+            size_t i = pos + 1;
+            while (i < size && isIdentChar(static_cast<unsigned char>(data[i]))) ++i;
+            length = i - pos;
+            kind = identifierKind(data + pos, length);
+        } else if (std::isdigit(c)) {
+            length = scanNumber(pos, kind);
+        } else if (c == '"') {
+            size_t i = pos + 1;
+            while (i < size && data[i] != '"') i += data[i] == '\\' ? 2 : 1;
+            if (i < size) {
+                kind = TokenKind::STRING_CONST;
+                length = i + 1 - pos;
+            } else {
+                length = size - pos; // 未闭合
+            }
+        } else {
+            kind = charTable.kind[c];
+            int next = peek(pos + 1);
+            if (next == '=' || next == '&' || next == '|') {
+                // 双字符运算符
+                length = 2;
+                if (c == '=' && next == '=') kind = TokenKind::EQ;
+                else if (c == '!' && next == '=') kind = TokenKind::NEQ;
+                else if (c == '<' && next == '=') kind = TokenKind::LE;
+                else if (c == '>' && next == '=') kind = TokenKind::GE;
+                else if (c == '&' && next == '&') kind = TokenKind::AND;
+                else if (c == '|' && next == '|') kind = TokenKind::OR;
+                else length = 1;
+            }
+        }
+        pos += length;
+        return {kind, start, length};
+    }
+
+    void position(const char* data, size_t offset, int& line, int& column) {
+        line = 1;
+        size_t lineStart = 0;
+        for (size_t i = 0; i < offset; ++i) {
+            if (data[i] == '\n') {
+                ++line;
+                lineStart = i + 1;
+            }
+        }
+        column = static_cast<int>(offset - lineStart) + 1;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef SPAN_SCANNER_H
+#define SPAN_SCANNER_H
+#include <cstddef>
+#include "token.h"
+
+namespace lexer {
+    // 内存中一个Token的种类和字节区间，不复制文本
+    struct TokenSpan {
+        TokenKind kind;
+        size_t offset;
+        size_t length;
+    };
+
+    // 在内存缓冲区上按与Lexer相同的规则逐个扫描Token，跳过空白和注释，只给出种类和区间
+    // 不构造字符串、不记录行列号，用于快速比较两段源码的Token序列；行列号需要时由position按偏移求出
+    class SpanScanner {
+    public:
+        SpanScanner(const char* data, size_t size) : data(data), size(size) {}
+        // 到末尾时返回EOF_TOKEN；遇到非法字符、未闭合的字符串或块注释时返回ERROR_TOKEN，此后仍可继续扫描
+        TokenSpan next();
+        const char* text(const TokenSpan& span) const { return data + span.offset; }
+    private:
+        const char* data;
+        size_t size;
+        size_t pos = 0;
+        int peek(size_t at) const { return at < size ? static_cast<unsigned char>(data[at]) : -1; }
+        bool skipTrivia(); // 跳过空白和注释；块注释未闭合时返回false，pos停在该注释开头
+        size_t scanNumber(size_t at, TokenKind& kind) const;
+    };
+
+    // 缓冲区中offset处的行号和列号（均从1开始）
+    void position(const char* data, size_t offset, int& line, int& column);
+}
+
+#endif //SPAN_SCANNER_H
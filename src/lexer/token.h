@@ -1,6 +1,8 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstddef>
+#include <cstdint>
 #include <unordered_map>
 #include <iostream>
 #include <unordered_set>
@@ -65,7 +67,7 @@ namespace lexer {
         LINE_COMMENT,    // 行注释 //
         BLOCK_COMMENT,   // 块注释 /**/
     };
-    static std::unordered_set<TokenKind> TypeSpecifiers = {
+    static const std::unordered_set<TokenKind> TypeSpecifiers = {
         TokenKind::INT,
         TokenKind::FLOAT,
         TokenKind::CHAR,
@@ -100,8 +102,12 @@ namespace lexer {
         std::string text;       // 单词自身值
         int line;               // 行号
         int column;             // 列号
-        void print() const {
-            std::cout << "Token(" << static_cast<int>(kind) << ", \"" << text << "\", " << line << ", " << column << ")\n";
+        size_t offset = 0;      // 在源码中的起始字节偏移
+        // 以下两项只在词法分析保留trivia（空白和注释）时记录，均为源码中的字节区间，不复制文本
+        uint32_t leading = 0;   // 前导trivia的字节数：源码[offset - leading, offset)
+        uint32_t trailing = 0;  // 尾随trivia的字节数：Token之后同一行的空白和注释，含行尾的换行符
+        void print(std::ostream& out = std::cout) const {
+            out << "Token(" << static_cast<int>(kind) << ", \"" << text << "\", " << line << ", " << column << ")\n";
         }
     };
 }
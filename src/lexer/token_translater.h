@@ -4,7 +4,7 @@
 #include "token.h"
 
 namespace lexer {
-    static std::unordered_map<int, std::string> TokenKindToStringMap = {
+    static const std::unordered_map<int, std::string> TokenKindToStringMap = {
         {static_cast<int>(TokenKind::ERROR_TOKEN), "ERROR_TOKEN"},
         {static_cast<int>(TokenKind::EOF_TOKEN), "EOF_TOKEN"},
         {static_cast<int>(TokenKind::IDENT), "IDENT"},
@@ -60,14 +60,14 @@ namespace lexer {
         {static_cast<int>(TokenKind::BLOCK_COMMENT), "BLOCK_COMMENT"},
     };
 
-    inline std::string TokenKindToString(TokenKind kind) {
-        if (TokenKindToStringMap.find(static_cast<int>(kind)) != TokenKindToStringMap.end()) {
-            return TokenKindToStringMap[static_cast<int>(kind)];
-        }
-        return "ERROR_TOKEN";
+    // 只读查表，可在多个线程中同时调用
+    inline const std::string& TokenKindToString(TokenKind kind) {
+        static const std::string error = "ERROR_TOKEN";
+        auto it = TokenKindToStringMap.find(static_cast<int>(kind));
+        return it != TokenKindToStringMap.end() ? it->second : error;
     }
 
-    static std::unordered_map<TokenKind,std::string> TokenKindToCNStringMap = {
+    static const std::unordered_map<TokenKind,std::string> TokenKindToCNStringMap = {
         {TokenKind::ERROR_TOKEN, "错误单词"},
         {TokenKind::EOF_TOKEN, "文件结束"},
         {TokenKind::IDENT, "标识符"},
@@ -123,11 +123,10 @@ namespace lexer {
         {TokenKind::LINE_COMMENT, "行注释"},
         {TokenKind::BLOCK_COMMENT, "块注释"},
     };
-    inline std::string TokenKindToCNString(TokenKind kind) {
-        if (TokenKindToCNStringMap.find(kind) != TokenKindToCNStringMap.end()) {
-            return TokenKindToCNStringMap[kind];
-        }
-        return "错误单词";
+    inline const std::string& TokenKindToCNString(TokenKind kind) {
+        static const std::string error = "错误单词";
+        auto it = TokenKindToCNStringMap.find(kind);
+        return it != TokenKindToCNStringMap.end() ? it->second : error;
     }
 }
 
@@ -1,12 +1,396 @@
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include "CLI/App.hpp"
 #include "CLI/Formatter.hpp"
 #include "CLI/Config.hpp"
 #include "parser.h"
+#include "ast_cache.h"
 #include "formatter.h"
+#include "format_cache.h"
+#include "token_verify.h"
+#include "style.h"
 #include "lexer.h"
 
+// 解析 --lines 的 A:B 参数
+static bool parseLineRanges(const std::vector<std::string>& specs, std::vector<formatter::LineRange>& ranges) {
+    for (const auto& spec : specs) {
+        formatter::LineRange range{0, 0};
+        char extra;
+        if (sscanf(spec.c_str(), "%d:%d%c", &range.first, &range.last, &extra) != 2 || range.first < 1 ||
+            range.last < range.first) {
+            std::cerr << "Invalid line range: " << spec << " (expected A:B with 1 <= A <= B)" << std::endl;
+            return false;
+        }
+        ranges.push_back(range);
+    }
+    return true;
+}
+
+// 格式化相关的命令行选项
+struct FormatOptions {
+    std::string output;
+    bool debug = false;
+    unsigned jobs = 1;
+    std::string astCache;
+    bool hashCons = false;
+    bool flatChains = false;
+    bool stream = false;
+    int width = 0;
+    std::vector<formatter::LineRange> lines;
+    bool check = false;
+    bool diff = false; // 把差异打印到标准输出而不写文件，退出码同检查模式
+    std::string formatCache;
+    size_t formatCacheSize = 1 << 16;
+    bool keepTrivia = false;
+    bool inPlace = false; // 结果写回输入文件，output与filename相同
+    bool quiet = false;   // 不打印输出文件名，原地改写时写的是临时文件
+    formatter::StyleId style = formatter::StyleId::AllmanStyle; // 启动时由风格名查得，见formatter::parseStyle
+    bool verify = false;          // 写出的结果须与输入的Token序列相同
+};
+
+static bool copyFile(const std::string& from, const std::string& to) {
+    FILE *in = fopen(from.c_str(), "rb");
+    if (!in) return false;
+    FILE *out = fopen(to.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+    char buf[1 << 16];
+    size_t n;
+    bool ok = true;
+    while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0) ok = fwrite(buf, 1, n, out) == n;
+    fclose(in);
+    return fclose(out) == 0 && ok;
+}
 
+static bool sameContent(const std::string& a, const std::string& b) {
+    FILE *fa = fopen(a.c_str(), "rb");
+    FILE *fb = fopen(b.c_str(), "rb");
+    bool same = fa && fb;
+    char bufA[1 << 16];
+    char bufB[1 << 16];
+    while (same) {
+        size_t na = fread(bufA, 1, sizeof(bufA), fa);
+        size_t nb = fread(bufB, 1, sizeof(bufB), fb);
+        same = na == nb && memcmp(bufA, bufB, na) == 0;
+        if (na == 0) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+// 在path所在目录下创建一个空的临时文件，重命名时不跨文件系统
+static bool makeTempFile(const std::string& path, std::string& tmp) {
+#ifdef _WIN32
+    tmp = path + ".hf-tmp";
+    FILE *file = fopen(tmp.c_str(), "wb");
+    if (!file) return false;
+    fclose(file);
+    return true;
+#else
+    std::vector<char> name(path.begin(), path.end());
+    const char suffix[] = ".hf-XXXXXX";
+    name.insert(name.end(), suffix, suffix + sizeof(suffix));
+    int fd = mkstemp(name.data());
+    if (fd < 0) return false;
+    close(fd);
+    tmp = name.data();
+    return true;
+#endif
+}
+
+// 用tmp替换target，tmp沿用target的权限位
+static bool replaceFile(const std::string& tmp, const std::string& target) {
+    struct stat st{};
+    if (stat(target.c_str(), &st) != 0) return false;
+#ifdef _WIN32
+    _chmod(tmp.c_str(), st.st_mode & (_S_IREAD | _S_IWRITE));
+    std::remove(target.c_str()); // Windows下rename不覆盖已有文件
+#else
+    if (chmod(tmp.c_str(), st.st_mode & 07777) != 0) return false;
+#endif
+    return std::rename(tmp.c_str(), target.c_str()) == 0;
+}
+
+// 格式化单个文件；指定了AST缓存且源文件未变化时直接从缓存加载AST，跳过词法和语法分析
+// 流式格式化时逐个顶层声明解析并输出，不使用缓存和多线程；指定了行区间时只格式化这些行
+// 检查模式不写文件，退出码0表示已格式化，1表示格式化会改变文件，2表示出错
+// Style为opts.style选定的风格，由runFormat在入口处分派
+template <class Style>
+static int formatInPlace(const std::string& filename, const FormatOptions& opts);
+
+template <class Style>
+static int runStyled(const std::string& filename, const FormatOptions& opts) {
+    using Formatter = formatter::BasicFormatter<Style>;
+    const std::string& output = opts.output;
+    auto report = [&opts](const char* what, const char* note) {
+        if (!opts.quiet) std::cout << what << opts.output << note << std::endl;
+    };
+    if (opts.check) {
+        auto result = Formatter::check(filename, opts.debug, opts.flatChains, opts.width);
+        if (result == formatter::CheckResult::Unformatted) std::cout << "Would reformat: " << filename << std::endl;
+        if (result == formatter::CheckResult::Failed) return 2;
+        return result == formatter::CheckResult::Formatted ? 0 : 1;
+    }
+    if (opts.diff) {
+        auto result = Formatter::diff(filename, stdout, opts.debug, opts.jobs, opts.flatChains, opts.width);
+        if (result == formatter::CheckResult::Failed) return 2;
+        return result == formatter::CheckResult::Formatted ? 0 : 1;
+    }
+    if (opts.inPlace) return formatInPlace<Style>(filename, opts);
+    if (!opts.lines.empty()) {
+        bool ok = Formatter::formatLines(filename, output, opts.lines, opts.debug, opts.flatChains, opts.width);
+        report("Formatted selected lines to file: ", "");
+        return ok ? 0 : EXIT_FAILURE;
+    }
+    if (opts.keepTrivia) {
+        bool ok = Formatter::formatTrivia(filename, output, opts.debug, opts.flatChains, opts.width);
+        report("Formatted output to file: ", " (comments and whitespace kept)");
+        return ok ? 0 : EXIT_FAILURE;
+    }
+    if (opts.stream) {
+        FILE *file = fopen(filename.c_str(), "r");
+        if (!file) {
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        bool ok = Formatter::formatStream(file, output, opts.debug, opts.hashCons, opts.flatChains, opts.width);
+        report("Formatted output to file: ", " (streamed)");
+        return ok ? 0 : EXIT_FAILURE;
+    }
+    uint64_t sourceHash = 0;
+    uint32_t shape = opts.flatChains ? parser::ShapeFlatChains : 0;
+    bool useCache = !opts.astCache.empty() && parser::hashFile(filename, sourceHash);
+    if (useCache) {
+        parser::ASTCache cache;
+        if (cache.load(opts.astCache, sourceHash, shape)) {
+            Formatter formatter(cache.materialize(), opts.debug, output);
+            formatter.jobs = opts.jobs;
+            formatter.width = opts.width;
+            formatter.format();
+            report("Formatted output to file: ", " (AST from cache)");
+            return 0;
+        }
+    }
+    FILE *file = fopen(filename.c_str(), "r");
+    if (!file) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    Formatter formatter(file, opts.debug, output, opts.jobs, opts.hashCons, opts.flatChains);
+    // 有语法错误的部分AST不进缓存
+    if (useCache && !formatter.hasErrors()) parser::ASTCache::save(opts.astCache, formatter.root(), sourceHash, shape);
+    formatter.width = opts.width;
+    formatter.format();
+    report("Formatted output to file: ", "");
+    return formatter.hasErrors() ? EXIT_FAILURE : 0;
+}
+
+// 原地格式化：先流式比较，输出与输入相同时不写任何东西，文件的修改时间不变；
+// 否则在同一目录下写临时文件，沿用原文件的权限，再重命名覆盖原文件，中途失败不会留下写了一半的文件。
+// 有语法错误时不改写，原文件保持不变
+template <class Style>
+static int formatInPlace(const std::string& filename, const FormatOptions& opts) {
+    using Formatter = formatter::BasicFormatter<Style>;
+    // 区间格式化和保留trivia时与整体格式化的结果不同，无法预先比较，写出后再比较
+    bool precheck = opts.lines.empty() && !opts.keepTrivia;
+    if (precheck) {
+        auto result = Formatter::check(filename, opts.debug, opts.flatChains, opts.width);
+        if (result == formatter::CheckResult::Formatted) {
+            std::cout << "File already formatted, left unchanged: " << filename << std::endl;
+            return 0;
+        }
+        if (result == formatter::CheckResult::Failed) {
+            std::cerr << "Syntax errors, left unchanged: " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::string tmp;
+    if (!makeTempFile(filename, tmp)) {
+        std::cerr << "Cannot create a temporary file next to: " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    FormatOptions tmpOpts = opts;
+    tmpOpts.output = tmp;
+    tmpOpts.inPlace = false;
+    tmpOpts.quiet = true;
+    if (runStyled<Style>(filename, tmpOpts) != 0) {
+        std::remove(tmp.c_str());
+        std::cerr << "Syntax errors, left unchanged: " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (opts.verify && !formatter::verifyTokens(filename, tmp)) {
+        std::remove(tmp.c_str());
+        std::cerr << "Left unchanged: " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!precheck && sameContent(filename, tmp)) {
+        std::remove(tmp.c_str());
+        std::cout << "File already formatted, left unchanged: " << filename << std::endl;
+        return 0;
+    }
+    if (!replaceFile(tmp, filename)) {
+        std::remove(tmp.c_str());
+        std::cerr << "Failed to replace file: " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Formatted file in place: " << filename << std::endl;
+    return 0;
+}
+
+// 按名字选出风格只在这里做一次，之后的格式化全程是该风格的特化代码
+static int runFormat(const std::string& filename, const FormatOptions& opts) {
+    return formatter::withStyle(opts.style, [&](auto style) { return runStyled<decltype(style)>(filename, opts); });
+}
+
+// 指定了格式化结果缓存时先按输入内容查缓存：
+// - 命中且输出与输入相同：检查直接通过，差异为空，格式化只需复制输入
+// - 命中且输出不同：检查直接失败；输出文件已是记录的内容时格式化无需重做
+// 未命中时正常格式化，成功后记录结果；区间格式化的结果取决于所选行，不走缓存
+static int formatCached(const std::string& filename, const FormatOptions& opts) {
+    uint64_t inputHash = 0;
+    uint64_t inputSize = 0;
+    if (opts.formatCache.empty() || !opts.lines.empty() ||
+        !formatter::hashContent(filename, inputHash, inputSize)) {
+        return runFormat(filename, opts);
+    }
+    formatter::FormatCache cache(opts.formatCache, opts.formatCacheSize);
+    unsigned flags = opts.keepTrivia ? formatter::FormatCache::KeepTrivia : 0;
+    flags |= static_cast<unsigned>(opts.style) << formatter::FormatCache::StyleShift;
+    uint64_t key = formatter::FormatCache::key(inputHash, inputSize, opts.width, flags);
+    formatter::FormatCacheEntry entry{};
+    if (cache.lookup(key, entry)) {
+        if (opts.check) {
+            if (!entry.unchanged) std::cout << "Would reformat: " << filename << " (cached)" << std::endl;
+            return entry.unchanged ? 0 : 1;
+        }
+        if (opts.diff && entry.unchanged) return 0;
+        if (entry.unchanged && opts.inPlace) {
+            std::cout << "File already formatted, left unchanged: " << filename << " (cached)" << std::endl;
+            return 0;
+        }
+        if (entry.unchanged && copyFile(filename, opts.output)) {
+            std::cout << "Formatted output to file: " << opts.output << " (unchanged, cached)" << std::endl;
+            return 0;
+        }
+        uint64_t outputHash = 0;
+        uint64_t outputSize = 0;
+        if (!opts.diff && !entry.unchanged && entry.outputHash &&
+            formatter::hashContent(opts.output, outputHash, outputSize) && outputHash == entry.outputHash) {
+            std::cout << "Output file is up to date: " << opts.output << " (cached)" << std::endl;
+            return 0;
+        }
+    }
+    int status = runFormat(filename, opts);
+    if (opts.check || opts.diff) {
+        // 检查发现不同时提前结束，差异模式不写输出，都只记录是否相同
+        if (status == 0 || status == 1) cache.store(key, {status == 0, status == 0 ? inputHash : 0});
+    } else if (status == 0) {
+        uint64_t outputHash = 0;
+        uint64_t outputSize = 0;
+        if (formatter::hashContent(opts.output, outputHash, outputSize)) {
+            cache.store(key, {outputHash == inputHash && outputSize == inputSize, outputHash});
+        }
+    }
+    return status;
+}
+
+// --verify：把输出重新做词法分析，与输入的Token序列比较；原地改写在替换原文件之前校验，其余情况写出后校验输出文件
+static int formatFile(const std::string& filename, const FormatOptions& opts) {
+    int status = formatCached(filename, opts);
+    if (status != 0 || !opts.verify || opts.inPlace || opts.check || opts.diff) return status;
+    return formatter::verifyTokens(filename, opts.output) ? 0 : EXIT_FAILURE;
+}
+
+// 一次解析同时输出的结果，路径为空的不输出
+struct ArtifactOptions {
+    std::string tokens;    // Token列表
+    std::string ast;       // AST，emit非空时按json或sexpr导出
+    std::string formatted; // 格式化结果
+    std::string emit;
+    bool sorted = false; // Token列表按种类排序
+    bool pretty = false;
+    bool cn = false;
+    bool any() const { return !tokens.empty() || !ast.empty() || !formatted.empty(); }
+};
+
+static bool writeTokens(lexer::Lexer& lexer, const ArtifactOptions& art) {
+    std::ofstream out(art.tokens);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open output file: " << art.tokens << std::endl;
+        return false;
+    }
+    if (art.cn) {
+        art.sorted ? lexer.printTokensSortedCN(out) : lexer.printTokensOrderCN(out);
+    } else if (art.pretty) {
+        art.sorted ? lexer.printTokensSortedPretty(out) : lexer.printTokensOrderPretty(out);
+    } else {
+        art.sorted ? lexer.printTokensSorted(out) : lexer.printTokensOrder(out);
+    }
+    out.close();
+    return !out.fail();
+}
+
+// 只做一次词法和语法分析，由同一份Token和AST依次输出Token列表、AST和格式化结果
+template <class Style>
+static int runArtifacts(const std::string& filename, const FormatOptions& opts, const ArtifactOptions& art) {
+    FILE *file = fopen(filename.c_str(), "r");
+    if (!file) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    // 导出的源码位置要求每处表达式各有节点，导出时不共享
+    bool hashCons = opts.hashCons && (art.ast.empty() || art.emit.empty());
+    formatter::BasicFormatter<Style> formatter(file, opts.debug, art.formatted, opts.jobs, hashCons, opts.flatChains);
+    parser::Parser& parser = formatter.syntax();
+    bool ok = !formatter.hasErrors();
+    if (!art.tokens.empty()) {
+        ok = writeTokens(parser.lexer, art) && ok;
+        std::cout << "Tokens output to file: " << art.tokens << std::endl;
+    }
+    if (!art.ast.empty()) {
+        std::string path = art.ast;
+        if (!art.emit.empty()) {
+            ok = parser.exportAST(path, art.emit) && ok;
+        } else {
+            parser.outputAST(path);
+        }
+        std::cout << "AST output to file: " << path << std::endl;
+    }
+    if (!art.formatted.empty()) {
+        formatter.width = opts.width;
+        formatter.format();
+        std::cout << "Formatted output to file: " << art.formatted << std::endl;
+        if (opts.verify) ok = formatter::verifyTokens(filename, art.formatted) && ok;
+    }
+    return ok ? 0 : EXIT_FAILURE;
+}
+
+// -p的输出：符号列表、--emit导出或AST树，返回退出码
+static int writeParseOutput(parser::Parser& parser, std::string& output, const std::string& emit, bool symbols) {
+    bool hasErrors = !parser.diagnostics.empty();
+    if (symbols) {
+        parser.outputSymbols(output);
+        std::cout << "Symbols output to file: " << output << std::endl;
+        return hasErrors ? EXIT_FAILURE : 0;
+    }
+    if (!emit.empty()) {
+        if (!parser.exportAST(output, emit)) return EXIT_FAILURE;
+    } else {
+        parser.outputAST(output);
+    }
+    std::cout << "AST output to file: " << output << std::endl;
+    return hasErrors ? EXIT_FAILURE : 0;
+}
 
 int main(const int argc, char** argv) {
     CLI::App app{"hust-formatter"};
@@ -20,7 +404,7 @@ int main(const int argc, char** argv) {
 
     // 输出文件参数
     std::string output;
-    app.add_option("-o,--output", output, "Output file")->default_val("");
+    auto *output_option = app.add_option("-o,--output", output, "Output file")->default_val("");
 
 
     bool lex_order = false;
@@ -37,8 +421,137 @@ int main(const int argc, char** argv) {
     app.add_flag("--lex-sort", lex_sort, "Print tokens sorted by kind");
     app.add_flag("-P,--pretty", pretty, "Pretty print output");
     app.add_flag("--cn", cn, "Print token kinds in Chinese");
+    unsigned jobs = 1;
+    app.add_option("-j,--jobs", jobs, "Parse and format top-level declarations with N threads")->default_val(1);
+    std::string ast_cache;
+    app.add_option("--ast-cache", ast_cache, "Binary AST cache file, reused while the source is unchanged");
+    std::string emit;
+    app.add_option("--emit", emit, "With --parse, export the full AST as json or sexpr")
+        ->check(CLI::IsMember({"json", "sexpr"}));
+    bool hash_cons = false;
+    app.add_flag("--hash-cons", hash_cons, "Share identical expression subtrees while parsing to save memory");
+    bool flat_chains = false;
+    app.add_flag("--flat-chains", flat_chains, "Build one n-ary node per chain of same-precedence operators");
+    bool symbols = false;
+    app.add_flag("--symbols", symbols, "With --parse, list top-level declarations without parsing function bodies");
+    int width = 0;
+    app.add_option("--width", width, "Wrap lines longer than N columns; 0 keeps every statement on one line")
+        ->default_val(0)->check(CLI::NonNegativeNumber);
+    bool in_place = false;
+    app.add_flag("-i,--in-place", in_place, "Rewrite the input file; files that are already formatted are not touched")
+        ->excludes(output_option);
+    bool check = false;
+    auto *check_option = app.add_flag("--check", check,
+                 "Write nothing; exit 0 if the file is already formatted, 1 if it would change, 2 on errors");
+    std::vector<std::string> line_specs;
+    app.add_option("--lines", line_specs, "Only reformat lines A:B (1-based, inclusive); may be repeated");
+    bool diff = false;
+    auto *diff_option = app.add_flag("--diff", diff,
+                 "Print a unified diff of the changes to stdout instead of writing a file; exit codes as --check")
+        ->excludes(check_option);
+    bool verify = false;
+    app.add_flag("--verify", verify,
+                 "Re-lex the written output and fail if its tokens differ from the input's (comments and whitespace aside)")
+        ->excludes(check_option)->excludes(diff_option);
+    bool keep_trivia = false;
+    app.add_flag("--keep-trivia", keep_trivia,
+                 "Keep all comments and correctly formatted whitespace; only rewrite whitespace that must change");
+    bool stream = false;
+    app.add_flag("--stream", stream,
+                 "Format each top-level declaration as soon as it is parsed; memory stays bounded by the largest one");
+    std::string format_cache;
+    app.add_option("--format-cache", format_cache,
+                   "Directory remembering formatted inputs by content hash; unchanged files are skipped");
+    size_t format_cache_size = 1 << 16;
+    app.add_option("--format-cache-size", format_cache_size, "Keep at most about N entries in --format-cache")
+        ->default_val(1 << 16)->check(CLI::PositiveNumber);
+    std::string style = "allman";
+    auto *style_option = app.add_option("--style", style,
+                                        "Formatting style: allman, kr, linux (tabs), compact (2 spaces), padded or minify")
+        ->default_val("allman")->check(CLI::IsMember(formatter::styleNames()));
+    bool minify = false;
+    app.add_flag("--minify", minify, "Drop comments and all whitespace not needed to separate tokens (--style minify)")
+        ->excludes(style_option);
+    ArtifactOptions artifacts;
+    app.add_option("--tokens-out", artifacts.tokens,
+                   "Write the token list to this file; may be combined with --ast-out and --format-out");
+    app.add_option("--ast-out", artifacts.ast, "Write the AST (or the --emit export) to this file from the same parse");
+    app.add_option("--format-out", artifacts.formatted, "Write the formatted code to this file from the same parse");
+    std::string profile_grammar;
+    app.add_option("--profile-grammar", profile_grammar,
+                   "With --parse, profile each grammar rule: print a table and write JSON to this file");
+    std::string reparse_from;
+    app.add_option("--reparse-from", reparse_from,
+                   "With --parse, parse this earlier version of the file first, then reparse only the "
+                   "top-level declarations the edit touched");
 
     CLI11_PARSE(app, argc, argv);
+    FormatOptions opts;
+    if (!parseLineRanges(line_specs, opts.lines)) return EXIT_FAILURE;
+    opts.debug = debug;
+    opts.jobs = jobs;
+    opts.astCache = ast_cache;
+    opts.hashCons = hash_cons;
+    opts.flatChains = flat_chains;
+    opts.stream = stream;
+    opts.width = width;
+    opts.check = check;
+    opts.formatCache = format_cache;
+    opts.formatCacheSize = format_cache_size;
+    opts.inPlace = in_place;
+    opts.keepTrivia = keep_trivia;
+    opts.diff = diff;
+    // 风格名只在这里检查一次，之后按StyleId分派
+    std::string style_name = minify ? "minify" : style;
+    if (!formatter::parseStyle(style_name, opts.style)) {
+        std::cerr << "Unknown style: " << style_name << std::endl;
+        return EXIT_FAILURE;
+    }
+    opts.verify = verify;
+    // 压缩输出要去掉全部注释和可省的空白，与保留trivia相矛盾
+    if (keep_trivia && opts.style == formatter::StyleId::MinifyStyle) {
+        std::cerr << "--keep-trivia cannot be combined with --minify or --style minify" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // 区间格式化把重排的声明拼回原样保留的源码中，压缩输出拼进去会得到一半压缩一半原样的文件
+    if (!opts.lines.empty() && opts.style == formatter::StyleId::MinifyStyle) {
+        std::cerr << "--lines cannot be combined with --minify or --style minify" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // 检查和差异模式总是与整体格式化的结果比较；区间格式化、保留trivia和流式格式化各自是一种输出方式，只能选一种
+    if ((check || diff) && (!opts.lines.empty() || keep_trivia || stream)) {
+        std::cerr << "--check and --diff cannot be combined with --lines, --keep-trivia or --stream" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!opts.lines.empty() + keep_trivia + stream > 1) {
+        std::cerr << "Only one of --lines, --keep-trivia and --stream can be given" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (artifacts.any()) {
+        // 其余模式各自有独立的读入和解析方式，不能共用这一次解析
+        if (lex_mode || parse_mode || format_mode || in_place || check || diff || keep_trivia || stream ||
+            !opts.lines.empty() || !output.empty() || !ast_cache.empty() || symbols || !profile_grammar.empty() ||
+            !reparse_from.empty()) {
+            std::cerr << "--tokens-out, --ast-out and --format-out cannot be combined with -l, -p, -F, -o, -i, "
+                         "--check, --diff, --lines, --keep-trivia, --stream, --ast-cache, --symbols, "
+                         "--profile-grammar or --reparse-from" << std::endl;
+            return EXIT_FAILURE;
+        }
+        artifacts.emit = emit;
+        artifacts.sorted = lex_sort;
+        artifacts.pretty = pretty;
+        artifacts.cn = cn;
+        std::cout << "Processing file in one pass: " << filename << std::endl;
+        return formatter::withStyle(opts.style, [&](auto style) {
+            return runArtifacts<decltype(style)>(filename, opts, artifacts);
+        });
+    }
+
+    if (!reparse_from.empty() && (!parse_mode || !ast_cache.empty())) {
+        std::cerr << "--reparse-from needs -p and cannot be combined with --ast-cache" << std::endl;
+        return EXIT_FAILURE;
+    }
 
     if (lex_mode) {
         std::cout << "Performing lexical analysis on file: " << filename << std::endl;
@@ -70,6 +583,54 @@ int main(const int argc, char** argv) {
         return 0;
     } else if (parse_mode) {
         std::cout << "Performing parsing on file: " << filename << std::endl;
+        parser::GrammarProfile profile;
+        if (!reparse_from.empty()) {
+            // 先完整解析旧版本，再按两版的差异增量重解析，得到的AST与直接解析新版本相同
+            std::string before;
+            std::string after;
+            if (!formatter::readFile(reparse_from, before)) {
+                std::cerr << "Failed to open file: " << reparse_from << std::endl;
+                return EXIT_FAILURE;
+            }
+            if (!formatter::readFile(filename, after)) {
+                std::cerr << "Failed to open file: " << filename << std::endl;
+                return EXIT_FAILURE;
+            }
+            parser::SourceEdit edit = parser::SourceEdit::between(before, after);
+            parser::Parser parser(std::vector<lexer::Token>{}, debug);
+            parser.jobs = jobs;
+            parser.lazyBodies = symbols;
+            parser.hashCons = hash_cons && emit.empty();
+            parser.flatChains = flat_chains;
+            parser.parseSource(std::move(before));
+            if (!profile_grammar.empty()) parser.profile = &profile;
+            parser.reparse(edit);
+            parser.printDiagnostics();
+            const auto& stats = parser.lastReparse;
+            std::cout << "Reparsed " << stats.reparsedRanges << " of " << stats.reparsedRanges + stats.reusedRanges
+                      << " top-level declarations (" << stats.relexedBytes << " bytes re-lexed)" << std::endl;
+            if (!profile_grammar.empty()) {
+                profile.printTable(std::cout);
+                if (!profile.writeJson(profile_grammar)) return EXIT_FAILURE;
+                std::cout << "Grammar profile written to file: " << profile_grammar << std::endl;
+            }
+            return writeParseOutput(parser, output, emit, symbols);
+        }
+        uint64_t sourceHash = 0;
+        uint32_t shape = flat_chains ? parser::ShapeFlatChains : 0;
+        // 导出的源码位置依赖Token序列，缓存只存节点的Token区间而没有Token本身，导出时不走缓存；
+        // 剖析和符号列表需要真正执行解析，同样不走缓存
+        bool useCache = !ast_cache.empty() && emit.empty() && profile_grammar.empty() && !symbols &&
+                        parser::hashFile(filename, sourceHash);
+        if (useCache) {
+            parser::ASTCache cache;
+            if (cache.load(ast_cache, sourceHash, shape)) {
+                parser::Parser parser(cache.materialize(), debug);
+                parser.outputAST(output);
+                std::cout << "AST output to file: " << output << " (AST from cache)" << std::endl;
+                return 0;
+            }
+        }
         FILE *file = fopen(filename.c_str(), "r");
         if (!file) {
             std::cerr << "Failed to open file: " << filename << std::endl;
@@ -93,38 +654,43 @@ int main(const int argc, char** argv) {
                 }
             }
         }
+        parser.jobs = jobs;
+        parser.lazyBodies = symbols;
+        // 导出的源码位置要求每处表达式各有节点，导出时不共享
+        parser.hashCons = hash_cons && emit.empty();
+        parser.flatChains = flat_chains;
+        if (!profile_grammar.empty()) parser.profile = &profile;
         parser.parse();
-        parser.outputAST(output);
-        std::cout << "AST output to file: " << output << std::endl;
-        return 0;
+        if (!profile_grammar.empty()) {
+            profile.printTable(std::cout);
+            if (!profile.writeJson(profile_grammar)) return EXIT_FAILURE;
+            std::cout << "Grammar profile written to file: " << profile_grammar << std::endl;
+        }
+        bool hasErrors = !parser.diagnostics.empty();
+        if (useCache && !hasErrors) parser::ASTCache::save(ast_cache, parser.parse(), sourceHash, shape);
+        return writeParseOutput(parser, output, emit, symbols);
     } else if (format_mode) {
-        if (output.empty()) {
+        if (in_place) {
+            output = filename;
+        } else if (output.empty()) {
             output = "formatted_" + filename;
         }
-        std::cout << "Formatting file: " << filename << " to " << output << std::endl;
-        FILE *file = fopen(filename.c_str(), "r");
-        if (!file) {
-            std::cerr << "Failed to open file: " << filename << std::endl;
-            exit(EXIT_FAILURE);
+        if (!check && !diff) {
+            std::cout << "Formatting file: " << filename << (in_place ? " in place" : " to " + output) << std::endl;
         }
-        formatter::Formatter formatter(file, debug, output);
-        formatter.format();
-        std::cout << "Formatted output to file: " << output << std::endl;
-        return 0;
+        opts.output = output;
+        return formatFile(filename, opts);
     } else {
         // 默认执行格式化
-        if (output.empty()) {
+        if (in_place) {
+            output = filename;
+        } else if (output.empty()) {
             output = "formatted_output.c";
         }
-        std::cout << "Formatting file: " << filename << " to " << output << std::endl;
-        FILE *file = fopen(filename.c_str(), "r");
-        if (!file) {
-            std::cerr << "Failed to open file: " << filename << std::endl;
-            exit(EXIT_FAILURE);
+        if (!check && !diff) {
+            std::cout << "Formatting file: " << filename << (in_place ? " in place" : " to " + output) << std::endl;
         }
-        formatter::Formatter formatter(file, debug, output);
-        formatter.format();
-        std::cout << "Formatted output to file: " << output << std::endl;
-        return 0;
+        opts.output = output;
+        return formatFile(filename, opts);
     }
 }
\ No newline at end of file
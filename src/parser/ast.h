@@ -1,6 +1,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -56,10 +57,12 @@ namespace parser {
         CharConst,          // 字符型常量
         StringConst,        // 字符串常量
         LineComment,         // 行注释
-        BlockComment        // 块注释
+        BlockComment,       // 块注释
+        // 占位
+        LazyBody            // 尚未解析的函数体，只记录Token区间
     };
 
-    static std::unordered_set<NodeType> terminalNodes = {
+    static const std::unordered_set<NodeType> terminalNodes = {
         Identifier,LongConst, IntConst, FloatConst, CharConst, StringConst
     };
 
@@ -72,7 +75,7 @@ namespace parser {
     }
 
     // TokenType到NodeType的映射表
-    static std::unordered_map<lexer::TokenKind, NodeType> tokenToNodeType = {
+    static const std::unordered_map<lexer::TokenKind, NodeType> tokenToNodeType = {
         {lexer::TokenKind::IDENT, Identifier},
         {lexer::TokenKind::LONG_CONST, LongConst},
         {lexer::TokenKind::INT_CONST, IntConst},
@@ -83,16 +86,17 @@ namespace parser {
 
     // 获取TokenKind对应的NodeType
     inline NodeType getTypeFromTokenKind(lexer::TokenKind kind) {
-        if (tokenToNodeType.find(kind) != tokenToNodeType.end()) {
-            return tokenToNodeType[kind];
-        }
-        return Unknown;
+        auto it = tokenToNodeType.find(kind);
+        return it != tokenToNodeType.end() ? it->second : Unknown;
     }
 
     struct ASTNode {
         NodeType type;
         std::vector<ASTNode*> children;
         std::string token;
+        int firstToken = -1; // 节点覆盖的第一个Token下标，-1表示未知
+        int lastToken = -1;  // 节点覆盖的最后一个Token下标，空节点为 firstToken - 1
+        bool shared = false; // 由表达式池或节点块持有的节点，父节点析构时不释放
 
         void print(int depth = 0) {
             for (int i = 0; i < depth; ++i) std::cout << "  ";
@@ -105,11 +109,21 @@ namespace parser {
         }
         ~ASTNode() {
             for (auto child : children) {
-                delete child;
+                if (child && !child->shared) delete child;
             }
-            delete this;
         }
     };
+
+    // 解析中暂存尚未挂到父节点上的子树，出错抛出或回溯时自动释放；共享节点归表达式池所有，不在此释放
+    struct NodeDeleter {
+        void operator()(ASTNode* node) const {
+            if (!node->shared) delete node;
+        }
+    };
+    using NodePtr = std::unique_ptr<ASTNode, NodeDeleter>;
+
+    // 一次分配的连续节点块（如从AST缓存重建的整棵树），0号为根；节点都标为shared，随块一起释放
+    using NodeArena = std::unique_ptr<ASTNode[]>;
 }
 
 #endif //AST_H
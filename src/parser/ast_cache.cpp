@@ -0,0 +1,192 @@
+#include "ast_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#include <fstream>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace parser {
+    static const char cacheMagic[4] = {'H', 'A', 'S', 'T'};
+    static const uint32_t cacheVersion = 3;
+
+    bool hashFile(const std::string& filename, uint64_t& hash) {
+        FILE* file = fopen(filename.c_str(), "rb");
+        if (!file) return false;
+        uint64_t h = 1469598103934665603ULL;
+        unsigned char buf[1 << 16];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                h ^= buf[i];
+                h *= 1099511628211ULL;
+            }
+        }
+        fclose(file);
+        hash = h;
+        return true;
+    }
+
+    bool ASTCache::save(const std::string& path, const ASTNode* root, uint64_t sourceHash, uint32_t shape) {
+        if (!root) return false;
+        // 层序展开，使每个节点的子节点连续
+        std::vector<const ASTNode*> order{root};
+        std::vector<CachedNode> records;
+        std::string strings;
+        std::unordered_map<std::string, uint32_t> stringOffsets;
+        for (size_t i = 0; i < order.size(); ++i) {
+            const ASTNode* node = order[i];
+            CachedNode rec{};
+            rec.type = static_cast<uint32_t>(node->type);
+            rec.firstChild = static_cast<uint32_t>(order.size());
+            rec.childCount = static_cast<uint32_t>(node->children.size());
+            rec.firstToken = node->firstToken;
+            rec.lastToken = node->lastToken;
+            if (!node->token.empty()) {
+                auto it = stringOffsets.find(node->token);
+                if (it == stringOffsets.end()) {
+                    it = stringOffsets.emplace(node->token, static_cast<uint32_t>(strings.size())).first;
+                    strings += node->token;
+                }
+                rec.tokenOffset = it->second;
+                rec.tokenLength = static_cast<uint32_t>(node->token.size());
+            }
+            records.push_back(rec);
+            for (auto* child : node->children) order.push_back(child);
+        }
+
+        ASTCacheHeader hdr{};
+        memcpy(hdr.magic, cacheMagic, sizeof(cacheMagic));
+        hdr.version = cacheVersion;
+        hdr.sourceHash = sourceHash;
+        hdr.nodeCount = static_cast<uint32_t>(records.size());
+        hdr.stringBytes = static_cast<uint32_t>(strings.size());
+        hdr.shape = shape;
+
+        // 临时文件名带进程号，同时写同一缓存的多个进程互不截断对方的临时文件
+        std::string tmp = path + "." + std::to_string(getpid()) + ".tmp";
+        FILE* out = fopen(tmp.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Cannot open AST cache file: " << tmp << std::endl;
+            return false;
+        }
+        bool ok = fwrite(&hdr, sizeof(hdr), 1, out) == 1 &&
+                  fwrite(records.data(), sizeof(CachedNode), records.size(), out) == records.size() &&
+                  fwrite(strings.data(), 1, strings.size(), out) == strings.size();
+        ok = fclose(out) == 0 && ok;
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool ASTCache::load(const std::string& path, uint64_t sourceHash, uint32_t shape) {
+        release();
+        ASTCacheHeader hdr{};
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) return false;
+        size_t fileSize = static_cast<size_t>(in.tellg());
+        in.seekg(0);
+        if (fileSize < sizeof(hdr) || !in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr))) return false;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        // 先只读文件头，哈希不一致时无需映射整个文件
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(hdr) ||
+            pread(fd, &hdr, sizeof(hdr), 0) != static_cast<ssize_t>(sizeof(hdr))) {
+            close(fd);
+            return false;
+        }
+        size_t fileSize = static_cast<size_t>(st.st_size);
+#endif
+        size_t expected = sizeof(hdr) + static_cast<size_t>(hdr.nodeCount) * sizeof(CachedNode) + hdr.stringBytes;
+        if (memcmp(hdr.magic, cacheMagic, sizeof(cacheMagic)) != 0 || hdr.version != cacheVersion ||
+            hdr.sourceHash != sourceHash || hdr.shape != shape || hdr.nodeCount == 0 || fileSize != expected) {
+#ifndef _WIN32
+            close(fd);
+#endif
+            return false;
+        }
+#ifdef _WIN32
+        data = ::operator new(fileSize);
+        in.seekg(0);
+        if (!in.read(static_cast<char*>(data), fileSize)) {
+            release();
+            return false;
+        }
+#else
+        void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = mapped;
+#endif
+        length = fileSize;
+        header = static_cast<const ASTCacheHeader*>(data);
+        nodes = reinterpret_cast<const CachedNode*>(static_cast<const char*>(data) + sizeof(ASTCacheHeader));
+        strings = reinterpret_cast<const char*>(nodes + header->nodeCount);
+        // 校验层序布局与字符串区间，避免损坏的缓存导致越界或共享子节点
+        uint64_t nextChild = 1;
+        for (uint32_t i = 0; i < header->nodeCount; ++i) {
+            const CachedNode& n = nodes[i];
+            if (n.firstChild != nextChild ||
+                static_cast<uint64_t>(n.tokenOffset) + n.tokenLength > header->stringBytes) {
+                release();
+                return false;
+            }
+            nextChild += n.childCount;
+        }
+        if (nextChild != header->nodeCount) {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    // 全部节点一次分配；子节点在记录中连续，在块中同样连续。节点标为shared，父节点析构时不逐个释放
+    NodeArena ASTCache::materialize() const {
+        if (!header) return nullptr;
+        NodeArena built(new ASTNode[header->nodeCount]);
+        for (uint32_t i = 0; i < header->nodeCount; ++i) {
+            const CachedNode& n = nodes[i];
+            ASTNode& node = built[i];
+            node.type = static_cast<NodeType>(n.type);
+            node.token.assign(tokenData(i), n.tokenLength);
+            node.firstToken = n.firstToken;
+            node.lastToken = n.lastToken;
+            node.shared = true;
+            node.children.resize(n.childCount);
+            for (uint32_t c = 0; c < n.childCount; ++c) node.children[c] = &built[n.firstChild + c];
+        }
+        return built;
+    }
+
+    void ASTCache::release() {
+        if (data) {
+#ifdef _WIN32
+            ::operator delete(data);
+#else
+            munmap(data, length);
+#endif
+        }
+        data = nullptr;
+        length = 0;
+        header = nullptr;
+        nodes = nullptr;
+        strings = nullptr;
+    }
+
+    ASTCache::~ASTCache() {
+        release();
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "ast.h"
+
+namespace parser {
+    // 二进制AST缓存文件布局：
+    //   ASTCacheHeader | CachedNode[nodeCount] | 字符串表[stringBytes]
+    // 节点按层序排列，每个节点的子节点在节点数组中连续存放，0号节点为根
+    // 文件按本机字节序写入，只用于同一台机器上的后续运行
+    struct ASTCacheHeader {
+        char magic[4];        // "HAST"
+        uint32_t version;
+        uint64_t sourceHash;  // 源文件内容哈希，不一致即拒绝加载
+        uint32_t nodeCount;
+        uint32_t stringBytes;
+        uint32_t shape;       // 生成该AST时影响树形的解析选项（ASTShape），不一致同样拒绝加载
+    };
+
+    // 改变AST形状的解析选项；相同源码在不同选项下得到不同的树，不能共用缓存
+    enum ASTShape : uint32_t {
+        ShapeFlatChains = 1u << 0, // Parser::flatChains
+    };
+
+    struct CachedNode {
+        uint32_t type;        // NodeType
+        uint32_t firstChild;  // 第一个子节点下标
+        uint32_t childCount;
+        uint32_t tokenOffset; // token在字符串表中的偏移
+        uint32_t tokenLength;
+        int32_t firstToken;   // 节点的Token区间，同ASTNode
+        int32_t lastToken;
+    };
+
+    // 计算文件内容的FNV-1a哈希
+    bool hashFile(const std::string& filename, uint64_t& hash);
+
+    class ASTCache {
+    public:
+        ASTCache() = default;
+        ASTCache(const ASTCache&) = delete;
+        ASTCache& operator=(const ASTCache&) = delete;
+        ~ASTCache();
+
+        // 将AST写入缓存文件（先写临时文件再重命名）
+        static bool save(const std::string& path, const ASTNode* root, uint64_t sourceHash, uint32_t shape);
+        // 映射缓存文件；文件头不合法、源文件哈希或shape不一致时返回false，此时不会映射文件
+        bool load(const std::string& path, uint64_t sourceHash, uint32_t shape);
+
+        uint32_t size() const { return header ? header->nodeCount : 0; }
+        const CachedNode& node(uint32_t i) const { return nodes[i]; }
+        const char* tokenData(uint32_t i) const { return strings + nodes[i].tokenOffset; }
+        uint32_t tokenLength(uint32_t i) const { return nodes[i].tokenLength; }
+        // 按缓存内容在一块连续内存中重建ASTNode树，供格式化等基于ASTNode的流程使用
+        NodeArena materialize() const;
+
+    private:
+        void release();
+        void* data = nullptr;
+        size_t length = 0;
+        const ASTCacheHeader* header = nullptr;
+        const CachedNode* nodes = nullptr;
+        const char* strings = nullptr;
+    };
+}
+
+#endif //AST_CACHE_H
@@ -1,5 +1,6 @@
 #include "parser.h"
 #include "ast.h"
+#include "ast_visitor.h"
 #include <vector>
 #include <fstream>
 #include <iostream>
@@ -20,415 +21,238 @@ namespace parser {
         out << "\n";
     }
 
-    // 递归输出AST
-    static void outputASTNode(std::ofstream& out, ASTNode* node, int indent = 0) {
-        if (!node) return;
-        switch (node->type) {
-            case NodeType::VarDecl: {
-                printIndent(out, indent);
-                out << "外部变量定义:\n";
-                // 类型
-                if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
-                    printIndent(out, indent + 1);
-                    out << "类型: " << node->children[0]->token << "\n";
-                }
-                // 变量名
-                printIndent(out, indent + 1);
-                out << "变量名:\n";
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
-                    printIndent(out, indent + 2);
-                    out << "ID: " << node->children[1]->token << "\n";
-                }
-                // 数组类型
-                if (node->children.size() > 2 && node->children[2]->type == NodeType::ArrayType) {
-                    printIndent(out, indent + 1);
-                    outputArrayType(out, node->children[2]);
-                }
-                // 初始化表达式
-                int initIdx = node->children.size() - 1;
-                if (node->children.size() > 2 && node->children[initIdx]->type != NodeType::ArrayType) {
-                    printIndent(out, indent + 1);
-                    out << "初始化表达式:\n";
-                    outputASTNode(out, node->children[initIdx], indent + 2);
-                }
-                break;
-            }
-            case NodeType::LocalVarDecl: {
-                printIndent(out, indent);
-                out << "局部变量定义:\n";
-                // 类型
-                if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
-                    printIndent(out, indent + 1);
-                    out << "类型: " << node->children[0]->token << "\n";
-                }
-                // 变量名
-                printIndent(out, indent + 1);
-                out << "变量名:\n";
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
-                    printIndent(out, indent + 2);
-                    out << "ID: " << node->children[1]->token << "\n";
-                }
-                // 数组类型
-                if (node->children.size() > 2 && node->children[2]->type == NodeType::ArrayType) {
-                    printIndent(out, indent + 1);
-                    outputArrayType(out, node->children[2]);
-                }
-                // 初始化表达式
-                int initIdx = node->children.size() - 1;
-                if (node->children.size() > 2 && node->children[initIdx]->type != NodeType::ArrayType) {
-                    printIndent(out, indent + 1);
-                    out << "初始化表达式:\n";
-                    outputASTNode(out, node->children[initIdx], indent + 2);
-                }
-                break;
-            }
-            case NodeType::Param: {
-                printIndent(out, indent);
-                out << "参数:\n";
-                // 类型
-                if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
-                    printIndent(out, indent + 1);
-                    out << "类型: " << node->children[0]->token << "\n";
-                }
-                // 参数名
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
-                    printIndent(out, indent + 1);
-                    out << "参数名: " << node->children[1]->token << "\n";
-                }
-                // 数组类型（递归显示所有维度）
-                for (size_t i = 2; i < node->children.size(); ++i) {
-                    if (node->children[i]->type == NodeType::ArrayType) {
-                        printIndent(out, indent + 1);
-                        outputArrayType(out, node->children[i]);
-                    }
-                }
-                break;
-            }
-            case NodeType::FunctionDef: {
-                printIndent(out, indent);
-                out << "函数定义:\n";
-                // 类型
-                if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
-                    printIndent(out, indent + 1);
-                    out << "类型: " << node->children[0]->token << "\n";
-                }
-                // 函数名
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
-                    printIndent(out, indent + 1);
-                    out << "函数名: " << node->children[1]->token << "\n";
-                }
-                // 参数
-                if (node->children.size() > 2 && node->children[2]->type == NodeType::ParamList) {
-                    printIndent(out, indent + 1);
-                    out << "函数参数:\n";
-                    for (auto* param : node->children[2]->children) {
-                        outputASTNode(out, param, indent + 2);
-                    }
-                }
-                // 复合语句
-                if (!node->children.empty() && node->children.back()->type == NodeType::CompoundStmt) {
-                    printIndent(out, indent + 1);
-                    out << "复合语句:\n";
-                    outputASTNode(out, node->children.back(), indent + 2);
-                }
-                break;
-            }
-            case NodeType::FunctionDecl: {
-                printIndent(out, indent);
-                out << "函数声明:\n";
-                // 类型
-                if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
-                    printIndent(out, indent + 1);
-                    out << "类型: " << node->children[0]->token << "\n";
-                }
-                // 函数名
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
-                    printIndent(out, indent + 1);
-                    out << "函数名: " << node->children[1]->token << "\n";
-                }
-                // 参数
-                if (node->children.size() > 2 && node->children[2]->type == NodeType::ParamList) {
-                    printIndent(out, indent + 1);
-                    out << "函数参数:\n";
-                    for (auto* param : node->children[2]->children) {
-                        outputASTNode(out, param, indent + 2);
-                    }
-                }
-                break;
-            }
-            case NodeType::CompoundStmt: {
-                // 复合语句的变量定义和语句部分
-                printIndent(out, indent);
-                out << "复合语句的变量定义:\n";
-                if (!node->children.empty() && node->children[0]->type == NodeType::VarDeclList) {
-                    outputASTNode(out, node->children[0], indent + 1);
-                }
-                printIndent(out, indent);
-                out << "复合语句的语句部分:\n";
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::StmtList) {
-                    outputASTNode(out, node->children[1], indent + 1);
-                }
-                break;
-            }
-            case NodeType::VarDeclList: {
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent);
-                }
-                break;
-            }
-            case NodeType::StmtList: {
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent);
-                }
-                break;
-            }
-            case NodeType::IfStmt: {
-                printIndent(out, indent);
-                out << "条件语句(IF_THEN_ELSE):\n";
-                printIndent(out, indent + 1);
-                out << "条件:\n";
-                outputASTNode(out, node->children[0], indent + 2);
-                printIndent(out, indent + 1);
-                out << "IF子句:\n";
-                outputASTNode(out, node->children[1], indent + 2);
-                if (node->children.size() > 2) {
-                    printIndent(out, indent + 1);
-                    out << "ELSE子句:\n";
-                    outputASTNode(out, node->children[2], indent + 2);
-                }
-                break;
-            }
-            case NodeType::ExprStmt: {
-                printIndent(out, indent);
-                out << "表达式语句:\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::ReturnStmt: {
-                printIndent(out, indent);
-                out << "返回语句:\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::AssignExpr: {
-                printIndent(out, indent);
-                out << "赋值表达式 (ASSIGNOP):\n";
-                if (node->children.size() > 0) {
-                    printIndent(out, indent + 1);
-                    out << "左值:\n";
-                    outputASTNode(out, node->children[0], indent + 2);
-                }
-                if (node->children.size() > 1) {
+    // 递归输出AST的遍历器，未单独处理的节点按原缩进输出子节点
+    class DisplayVisitor : public ASTVisitor<DisplayVisitor> {
+    public:
+        explicit DisplayVisitor(std::ofstream& out) : out(out) {}
+
+        bool visitVarDecl(ASTNode* node) { return varDecl(node, "外部变量定义:\n"); }
+        bool visitLocalVarDecl(ASTNode* node) { return varDecl(node, "局部变量定义:\n"); }
+
+        bool visitParam(ASTNode* node) {
+            line(0) << "参数:\n";
+            // 类型
+            if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
+                line(1) << "类型: " << node->children[0]->token << "\n";
+            }
+            // 参数名
+            if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
+                line(1) << "参数名: " << node->children[1]->token << "\n";
+            }
+            // 数组类型（递归显示所有维度）
+            for (size_t i = 2; i < node->children.size(); ++i) {
+                if (node->children[i]->type == NodeType::ArrayType) {
                     printIndent(out, indent + 1);
-                    out << "右值:\n";
-                    outputASTNode(out, node->children[1], indent + 2);
-                }
-                break;
-            }
-            case NodeType::LogicalAndExpr: {
-                printIndent(out, indent);
-                out << "逻辑与表达式 (&&):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::LogicalOrExpr: {
-                printIndent(out, indent);
-                out << "逻辑或表达式 (||):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::EqualityExpr: {
-                printIndent(out, indent);
-                out << "相等表达式 (" << node->token << "):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::RelationalExpr: {
-                printIndent(out, indent);
-                out << "关系表达式 (" << node->token << "):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
+                    outputArrayType(out, node->children[i]);
                 }
-                break;
             }
-            case NodeType::AdditiveExpr: {
-                printIndent(out, indent);
-                out << "加减表达式 (" << node->token << "):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::MultiplicativeExpr: {
-                printIndent(out, indent);
-                out << "乘除模表达式 (" << node->token << "):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::UnaryExpr: {
-                printIndent(out, indent);
-                out << "一元表达式 (" << node->token << "):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::PostfixExpr: {
-                printIndent(out, indent);
-                out << "函数调用:\n";
-                if (!node->children.empty() && node->children[0]->type == NodeType::Identifier) {
-                    printIndent(out, indent + 1);
-                    out << "函数名: " << node->children[0]->token << "\n";
-                }
-                if (node->children.size() > 1 && node->children[1]->type == NodeType::ArgList) {
-                    printIndent(out, indent + 1);
-                    out << "参数列表:\n";
-                    outputASTNode(out, node->children[1], indent + 2);
-                }
-                break;
+            return true;
+        }
+
+        bool visitFunctionDef(ASTNode* node) {
+            function(node, "函数定义:\n");
+            // 复合语句
+            if (!node->children.empty() && node->children.back()->type == NodeType::CompoundStmt) {
+                line(1) << "复合语句:\n";
+                at(2, node->children.back());
+            }
+            return true;
+        }
+
+        bool visitFunctionDecl(ASTNode* node) {
+            function(node, "函数声明:\n");
+            return true;
+        }
+
+        bool visitCompoundStmt(ASTNode* node) {
+            // 复合语句的变量定义和语句部分
+            line(0) << "复合语句的变量定义:\n";
+            if (!node->children.empty() && node->children[0]->type == NodeType::VarDeclList) {
+                at(1, node->children[0]);
             }
-            case NodeType::ArgList: {
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent);
-                }
-                break;
+            line(0) << "复合语句的语句部分:\n";
+            if (node->children.size() > 1 && node->children[1]->type == NodeType::StmtList) {
+                at(1, node->children[1]);
             }
-            case NodeType::Identifier: {
-                printIndent(out, indent);
-                out << "ID: " << node->token << "\n";
-                break;
+            return true;
+        }
+
+        bool visitIfStmt(ASTNode* node) {
+            line(0) << "条件语句(IF_THEN_ELSE):\n";
+            line(1) << "条件:\n";
+            at(2, node->children[0]);
+            line(1) << "IF子句:\n";
+            at(2, node->children[1]);
+            if (node->children.size() > 2) {
+                line(1) << "ELSE子句:\n";
+                at(2, node->children[2]);
+            }
+            return true;
+        }
+
+        bool visitWhileStmt(ASTNode* node) {
+            line(0) << "循环语句(WHILE):\n";
+            line(1) << "条件:\n";
+            at(2, node->children[0]);
+            line(1) << "循环体:\n";
+            at(2, node->children[1]);
+            return true;
+        }
+
+        bool visitForStmt(ASTNode* node) {
+            line(0) << "循环语句(FOR):\n";
+            line(1) << "初始化:\n";
+            at(2, node->children[0]);
+            line(1) << "条件:\n";
+            at(2, node->children[1]);
+            line(1) << "步进:\n";
+            at(2, node->children[2]);
+            line(1) << "循环体:\n";
+            at(2, node->children[3]);
+            return true;
+        }
+
+        bool visitExprStmt(ASTNode* node) { return labeled(node, "表达式语句:\n"); }
+        bool visitReturnStmt(ASTNode* node) { return labeled(node, "返回语句:\n"); }
+        bool visitBreakStmt(ASTNode*) { line(0) << "BREAK语句\n"; return true; }
+        bool visitContinueStmt(ASTNode*) { line(0) << "CONTINUE语句\n"; return true; }
+
+        bool visitAssignExpr(ASTNode* node) {
+            line(0) << "赋值表达式 (ASSIGNOP):\n";
+            if (node->children.size() > 0) {
+                line(1) << "左值:\n";
+                at(2, node->children[0]);
             }
-            case NodeType::IntConst: {
-                printIndent(out, indent);
-                out << "INT_CONST: " << node->token << "\n";
-                break;
+            if (node->children.size() > 1) {
+                line(1) << "右值:\n";
+                at(2, node->children[1]);
             }
-            case NodeType::LongConst: {
-                printIndent(out, indent);
-                out << "LONG_CONST: " << node->token << "\n";
-                break;
+            return true;
+        }
+
+        bool visitLogicalAndExpr(ASTNode* node) { return labeled(node, "逻辑与表达式 (&&):\n"); }
+        bool visitLogicalOrExpr(ASTNode* node) { return labeled(node, "逻辑或表达式 (||):\n"); }
+        bool visitEqualityExpr(ASTNode* node) { return withOp(node, "相等表达式 ("); }
+        bool visitRelationalExpr(ASTNode* node) { return withOp(node, "关系表达式 ("); }
+        bool visitAdditiveExpr(ASTNode* node) { return withOp(node, "加减表达式 ("); }
+        bool visitMultiplicativeExpr(ASTNode* node) { return withOp(node, "乘除模表达式 ("); }
+        bool visitUnaryExpr(ASTNode* node) { return withOp(node, "一元表达式 ("); }
+
+        bool visitPostfixExpr(ASTNode* node) {
+            line(0) << "函数调用:\n";
+            if (!node->children.empty() && node->children[0]->type == NodeType::Identifier) {
+                line(1) << "函数名: " << node->children[0]->token << "\n";
             }
-            case NodeType::FloatConst: {
-                printIndent(out, indent);
-                out << "FLOAT_CONST: " << node->token << "\n";
-                break;
+            if (node->children.size() > 1 && node->children[1]->type == NodeType::ArgList) {
+                line(1) << "参数列表:\n";
+                at(2, node->children[1]);
             }
-            case NodeType::CharConst: {
-                printIndent(out, indent);
-                out << "CHAR_CONST: " << node->token << "\n";
-                break;
+            return true;
+        }
+
+        bool visitArrayAccess(ASTNode* node) {
+            line(0) << "数组访问:\n";
+            if (!node->children.empty()) {
+                line(1) << "被访问对象:\n";
+                at(2, node->children[0]);
             }
-            case NodeType::StringConst: {
-                printIndent(out, indent);
-                out << "STRING_CONST: " << node->token << "\n";
-                break;
+            if (node->children.size() > 1) {
+                line(1) << "下标:\n";
+                at(2, node->children[1]);
             }
-            case NodeType::Program: {
-                printIndent(out, indent);
-                out << "Program(程序):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
+            return true;
+        }
+
+        bool visitParenthesizedExpr(ASTNode* node) { return labeled(node, "括号表达式:\n"); }
+
+        bool visitIdentifier(ASTNode* node) { return leaf(node, "ID: "); }
+        bool visitIntConst(ASTNode* node) { return leaf(node, "INT_CONST: "); }
+        bool visitLongConst(ASTNode* node) { return leaf(node, "LONG_CONST: "); }
+        bool visitFloatConst(ASTNode* node) { return leaf(node, "FLOAT_CONST: "); }
+        bool visitCharConst(ASTNode* node) { return leaf(node, "CHAR_CONST: "); }
+        bool visitStringConst(ASTNode* node) { return leaf(node, "STRING_CONST: "); }
+        bool visitLineComment(ASTNode* node) { return leaf(node, ""); }
+        bool visitBlockComment(ASTNode* node) { return leaf(node, ""); }
+
+        bool visitProgram(ASTNode* node) { return labeled(node, "Program(程序):\n"); }
+        bool visitExternalDeclList(ASTNode* node) { return labeled(node, "ExternalDeclList(外部声明列表):\n"); }
+
+    private:
+        std::ofstream& out;
+        int indent = 0;
+
+        // 在当前缩进基础上再缩进delta级后开始一行
+        std::ofstream& line(int delta) {
+            printIndent(out, indent + delta);
+            return out;
+        }
+
+        // 以更深delta级的缩进输出子树
+        void at(int delta, ASTNode* node) {
+            indent += delta;
+            traverse(node);
+            indent -= delta;
+        }
+
+        bool labeled(ASTNode* node, const char* label) {
+            line(0) << label;
+            for (auto* child : node->children) at(1, child);
+            return true;
+        }
+
+        bool withOp(ASTNode* node, const char* label) {
+            line(0) << label << node->token << "):\n";
+            for (auto* child : node->children) at(1, child);
+            return true;
+        }
+
+        bool leaf(ASTNode* node, const char* label) {
+            line(0) << label << node->token << "\n";
+            return true;
+        }
+
+        void function(ASTNode* node, const char* label) {
+            line(0) << label;
+            // 类型
+            if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
+                line(1) << "类型: " << node->children[0]->token << "\n";
             }
-            case NodeType::ExternalDeclList: {
-                printIndent(out, indent);
-                out << "ExternalDeclList(外部声明列表):\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
+            // 函数名
+            if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
+                line(1) << "函数名: " << node->children[1]->token << "\n";
             }
-            case NodeType::WhileStmt: {
-                printIndent(out, indent);
-                out << "循环语句(WHILE):\n";
-                printIndent(out, indent + 1);
-                out << "条件:\n";
-                outputASTNode(out, node->children[0], indent + 2);
-                printIndent(out, indent + 1);
-                out << "循环体:\n";
-                outputASTNode(out, node->children[1], indent + 2);
-                break;
+            // 参数
+            if (node->children.size() > 2 && node->children[2]->type == NodeType::ParamList) {
+                line(1) << "函数参数:\n";
+                for (auto* param : node->children[2]->children) at(2, param);
             }
-            case NodeType::ForStmt: {
-                printIndent(out, indent);
-                out << "循环语句(FOR):\n";
-                printIndent(out, indent + 1);
-                out << "初始化:\n";
-                outputASTNode(out, node->children[0], indent + 2);
-                printIndent(out, indent + 1);
-                out << "条件:\n";
-                outputASTNode(out, node->children[1], indent + 2);
-                printIndent(out, indent + 1);
-                out << "步进:\n";
-                outputASTNode(out, node->children[2], indent + 2);
+        }
+
+        bool varDecl(ASTNode* node, const char* label) {
+            line(0) << label;
+            // 类型
+            if (!node->children.empty() && node->children[0]->type == NodeType::TypeSpec) {
+                line(1) << "类型: " << node->children[0]->token << "\n";
+            }
+            // 变量名
+            line(1) << "变量名:\n";
+            if (node->children.size() > 1 && node->children[1]->type == NodeType::Identifier) {
+                line(2) << "ID: " << node->children[1]->token << "\n";
+            }
+            // 数组类型
+            if (node->children.size() > 2 && node->children[2]->type == NodeType::ArrayType) {
                 printIndent(out, indent + 1);
-                out << "循环体:\n";
-                outputASTNode(out, node->children[3], indent + 2);
-                break;
+                outputArrayType(out, node->children[2]);
             }
-            case NodeType::BreakStmt: {
-                printIndent(out, indent);
-                out << "BREAK语句\n";
-                break;
+            // 初始化表达式
+            size_t initIdx = node->children.size() - 1;
+            if (node->children.size() > 2 && node->children[initIdx]->type != NodeType::ArrayType) {
+                line(1) << "初始化表达式:\n";
+                at(2, node->children[initIdx]);
             }
-            case NodeType::ContinueStmt: {
-                printIndent(out, indent);
-                out << "CONTINUE语句\n";
-                break;
-            }
-            case NodeType::ArrayAccess: {
-                printIndent(out, indent);
-                out << "数组访问:\n";
-                if (!node->children.empty()) {
-                    printIndent(out, indent + 1);
-                    out << "被访问对象:\n";
-                    outputASTNode(out, node->children[0], indent + 2);
-                }
-                if (node->children.size() > 1) {
-                    printIndent(out, indent + 1);
-                    out << "下标:\n";
-                    outputASTNode(out, node->children[1], indent + 2);
-                }
-                break;
-            }
-            case NodeType::ParenthesizedExpr: {
-                printIndent(out, indent);
-                out << "括号表达式:\n";
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent + 1);
-                }
-                break;
-            }
-            case NodeType::LineComment: {
-                printIndent(out, indent);
-                out << node->token << "\n";
-                break;
-            }
-            case NodeType::BlockComment: {
-                printIndent(out, indent);
-                out << node->token << "\n";
-                break;
-            }
-            default:
-                for (auto* child : node->children) {
-                    outputASTNode(out, child, indent);
-                }
-                break;
+            return true;
         }
-    }
+    };
 
     void Parser::outputAST(std::string& filename) {
         if (filename.empty()) {
@@ -443,7 +267,8 @@ namespace parser {
             std::cerr << "No AST to output." << std::endl;
             return;
         }
-        outputASTNode(out, root, 0);
+        expandBodies();
+        DisplayVisitor(out).traverse(root);
         out.close();
     }
 }
\ No newline at end of file
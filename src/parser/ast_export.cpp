@@ -0,0 +1,211 @@
+#include "parser.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "buffered_writer.h"
+#include "translater.h"
+#include <iostream>
+
+namespace parser {
+    // 源码位置区间：行列号从1开始，结束列不含在区间内
+    struct SourceSpan {
+        int line;
+        int column;
+        int endLine;
+        int endColumn;
+    };
+
+    // 由节点覆盖的Token区间换算源码位置，节点没有位置信息时返回false
+    static bool spanOf(const ASTNode* node, const std::vector<lexer::Token>& tokens, SourceSpan& span) {
+        if (node->firstToken < 0 || node->firstToken >= (int)tokens.size()) return false;
+        const auto& first = tokens[node->firstToken];
+        span.line = first.line;
+        span.column = first.column;
+        if (node->lastToken < node->firstToken || node->lastToken >= (int)tokens.size()) {
+            span.endLine = span.line;
+            span.endColumn = span.column;
+            return true;
+        }
+        const auto& last = tokens[node->lastToken];
+        span.endLine = last.line;
+        span.endColumn = last.column + (int)last.text.size();
+        // 跨行的块注释
+        size_t newline = last.text.rfind('\n');
+        if (newline != std::string::npos) {
+            for (char c : last.text) {
+                if (c == '\n') span.endLine++;
+            }
+            span.endColumn = (int)(last.text.size() - newline);
+        }
+        return true;
+    }
+
+    // 输出带转义的字符串常量，json与sexpr共用同一套转义规则；无需转义的片段整段写出
+    static void writeQuoted(BufferedWriter& out, const std::string& s) {
+        static const char hex[] = "0123456789abcdef";
+        out.put('"');
+        size_t start = 0;
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out.write(s.data() + start, i - start);
+            start = i + 1;
+            switch (c) {
+                case '"': out.write("\\\"", 2); break;
+                case '\\': out.write("\\\\", 2); break;
+                case '\n': out.write("\\n", 2); break;
+                case '\r': out.write("\\r", 2); break;
+                case '\t': out.write("\\t", 2); break;
+                default:
+                    out.write("\\u00", 4);
+                    out.put(hex[c >> 4]);
+                    out.put(hex[c & 0xf]);
+            }
+        }
+        out.write(s.data() + start, s.size() - start);
+        out.put('"');
+    }
+
+    // 节点类型名按枚举值缓存，避免每个节点一次哈希查找
+    static const std::string& typeName(NodeType type) {
+        static const std::vector<std::string> names = [] {
+            std::vector<std::string> v;
+            for (int t = Unknown; t <= LazyBody; ++t) v.push_back(getNodeTypeString(static_cast<NodeType>(t)));
+            return v;
+        }();
+        return type >= Unknown && type <= LazyBody ? names[type] : names[Unknown];
+    }
+
+    // {"type":"...","token":"...","span":[line,col,endLine,endCol],"children":[...]}
+    class JsonExporter : public ASTVisitor<JsonExporter> {
+    public:
+        JsonExporter(BufferedWriter& out, const std::vector<lexer::Token>& tokens) : out(out), tokens(tokens) {}
+
+        bool preVisit(ASTNode* node) {
+            out.write("{\"type\":\"", 9);
+            out.write(typeName(node->type));
+            out.put('"');
+            if (!node->token.empty()) {
+                out.write(",\"token\":", 9);
+                writeQuoted(out, node->token);
+            }
+            SourceSpan span{};
+            if (spanOf(node, tokens, span)) {
+                out.write(",\"span\":[", 9);
+                out.writeInt(span.line);
+                out.put(',');
+                out.writeInt(span.column);
+                out.put(',');
+                out.writeInt(span.endLine);
+                out.put(',');
+                out.writeInt(span.endColumn);
+                out.put(']');
+            }
+            out.write(",\"children\":[", 13);
+            return true;
+        }
+
+        bool visitNode(ASTNode* node) {
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (i) out.put(',');
+                if (node->children[i]) {
+                    traverse(node->children[i]);
+                } else {
+                    out.write("null", 4);
+                }
+            }
+            return true;
+        }
+
+        bool postVisit(ASTNode*) {
+            out.write("]}", 2);
+            return true;
+        }
+
+    private:
+        BufferedWriter& out;
+        const std::vector<lexer::Token>& tokens;
+    };
+
+    // (Type "token" (span line col endLine endCol) child ...)
+    class SExprExporter : public ASTVisitor<SExprExporter> {
+    public:
+        SExprExporter(BufferedWriter& out, const std::vector<lexer::Token>& tokens) : out(out), tokens(tokens) {}
+
+        bool preVisit(ASTNode* node) {
+            out.put('(');
+            out.write(typeName(node->type));
+            if (!node->token.empty()) {
+                out.put(' ');
+                writeQuoted(out, node->token);
+            }
+            SourceSpan span{};
+            if (spanOf(node, tokens, span)) {
+                out.write(" (span ", 7);
+                out.writeInt(span.line);
+                out.put(' ');
+                out.writeInt(span.column);
+                out.put(' ');
+                out.writeInt(span.endLine);
+                out.put(' ');
+                out.writeInt(span.endColumn);
+                out.put(')');
+            }
+            return true;
+        }
+
+        bool visitNode(ASTNode* node) {
+            for (auto* child : node->children) {
+                out.put(' ');
+                if (child) {
+                    traverse(child);
+                } else {
+                    out.write("nil", 3);
+                }
+            }
+            return true;
+        }
+
+        bool postVisit(ASTNode*) {
+            out.put(')');
+            return true;
+        }
+
+    private:
+        BufferedWriter& out;
+        const std::vector<lexer::Token>& tokens;
+    };
+
+    bool Parser::exportAST(std::string& filename, const std::string& format) {
+        if (format != "json" && format != "sexpr") {
+            std::cerr << "Unknown AST export format: " << format << std::endl;
+            return false;
+        }
+        if (filename.empty()) {
+            filename = "ast." + format;
+        }
+        if (!root) {
+            std::cerr << "No AST to output." << std::endl;
+            return false;
+        }
+        expandBodies();
+        FILE* file = fopen(filename.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Cannot open output file: " << filename << std::endl;
+            return false;
+        }
+        bool ok;
+        {
+            BufferedWriter out(file);
+            if (format == "json") {
+                JsonExporter(out, tokens).traverse(root);
+            } else {
+                SExprExporter(out, tokens).traverse(root);
+            }
+            out.put('\n');
+            ok = out.flush();
+        }
+        ok = fclose(file) == 0 && ok;
+        if (!ok) std::cerr << "Failed to write AST to file: " << filename << std::endl;
+        return ok;
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef AST_VISITOR_H
+#define AST_VISITOR_H
+#include "ast.h"
+
+namespace parser {
+    // 静态分派的AST遍历基类（CRTP），派生类以 class X : public ASTVisitor<X> 的方式继承
+    // - 派生类按需提供同名的 visitXxx(ASTNode*) 即可覆盖对应节点类型的处理，分派在编译期完成，无虚函数调用
+    // - 未覆盖的节点类型统一走 visitNode，默认按顺序遍历全部子节点
+    // - preVisit 返回false时跳过该节点及其子树；postVisit 在节点处理完后调用
+    // - 任一 visit/postVisit 返回false时整个遍历提前结束，traverse 返回false
+    template <typename Derived>
+    class ASTVisitor {
+    public:
+        bool traverse(ASTNode* node) {
+            if (!node) return true;
+            if (!derived().preVisit(node)) return true;
+            if (!dispatch(node)) return false;
+            return derived().postVisit(node);
+        }
+
+        bool visitChildren(ASTNode* node) {
+            for (auto* child : node->children) {
+                if (!derived().traverse(child)) return false;
+            }
+            return true;
+        }
+
+        // 遍历钩子
+        bool preVisit(ASTNode*) { return true; }
+        bool postVisit(ASTNode*) { return true; }
+        bool visitNode(ASTNode* node) { return derived().visitChildren(node); }
+
+        // 顶层结构
+        bool visitProgram(ASTNode* node) { return derived().visitNode(node); }
+        bool visitExternalDeclList(ASTNode* node) { return derived().visitNode(node); }
+        bool visitFunctionDef(ASTNode* node) { return derived().visitNode(node); }
+        bool visitFunctionDecl(ASTNode* node) { return derived().visitNode(node); }
+        bool visitVarDecl(ASTNode* node) { return derived().visitNode(node); }
+        bool visitLocalVarDecl(ASTNode* node) { return derived().visitNode(node); }
+        bool visitVarDeclList(ASTNode* node) { return derived().visitNode(node); }
+        bool visitParamList(ASTNode* node) { return derived().visitNode(node); }
+        bool visitParam(ASTNode* node) { return derived().visitNode(node); }
+        bool visitCompoundStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitStmtList(ASTNode* node) { return derived().visitNode(node); }
+
+        // 语句
+        bool visitExprStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitIfStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitWhileStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitForStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitReturnStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitBreakStmt(ASTNode* node) { return derived().visitNode(node); }
+        bool visitContinueStmt(ASTNode* node) { return derived().visitNode(node); }
+
+        // 表达式
+        bool visitAssignExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitLogicalOrExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitLogicalAndExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitEqualityExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitRelationalExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitAdditiveExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitMultiplicativeExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitUnaryExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitPostfixExpr(ASTNode* node) { return derived().visitNode(node); }
+        bool visitArgList(ASTNode* node) { return derived().visitNode(node); }
+        bool visitArrayAccess(ASTNode* node) { return derived().visitNode(node); }
+        bool visitParenthesizedExpr(ASTNode* node) { return derived().visitNode(node); }
+
+        // 类型与终结符
+        bool visitTypeSpec(ASTNode* node) { return derived().visitNode(node); }
+        bool visitArrayType(ASTNode* node) { return derived().visitNode(node); }
+        bool visitIdentifier(ASTNode* node) { return derived().visitNode(node); }
+        bool visitLongConst(ASTNode* node) { return derived().visitNode(node); }
+        bool visitIntConst(ASTNode* node) { return derived().visitNode(node); }
+        bool visitFloatConst(ASTNode* node) { return derived().visitNode(node); }
+        bool visitCharConst(ASTNode* node) { return derived().visitNode(node); }
+        bool visitStringConst(ASTNode* node) { return derived().visitNode(node); }
+        bool visitLineComment(ASTNode* node) { return derived().visitNode(node); }
+        bool visitBlockComment(ASTNode* node) { return derived().visitNode(node); }
+        bool visitLazyBody(ASTNode* node) { return derived().visitNode(node); }
+
+    protected:
+        Derived& derived() { return *static_cast<Derived*>(this); }
+
+        bool dispatch(ASTNode* node) {
+            switch (node->type) {
+                case Program: return derived().visitProgram(node);
+                case ExternalDeclList: return derived().visitExternalDeclList(node);
+                case FunctionDef: return derived().visitFunctionDef(node);
+                case FunctionDecl: return derived().visitFunctionDecl(node);
+                case VarDecl: return derived().visitVarDecl(node);
+                case LocalVarDecl: return derived().visitLocalVarDecl(node);
+                case VarDeclList: return derived().visitVarDeclList(node);
+                case ParamList: return derived().visitParamList(node);
+                case Param: return derived().visitParam(node);
+                case CompoundStmt: return derived().visitCompoundStmt(node);
+                case StmtList: return derived().visitStmtList(node);
+                case ExprStmt: return derived().visitExprStmt(node);
+                case IfStmt: return derived().visitIfStmt(node);
+                case WhileStmt: return derived().visitWhileStmt(node);
+                case ForStmt: return derived().visitForStmt(node);
+                case ReturnStmt: return derived().visitReturnStmt(node);
+                case BreakStmt: return derived().visitBreakStmt(node);
+                case ContinueStmt: return derived().visitContinueStmt(node);
+                case AssignExpr: return derived().visitAssignExpr(node);
+                case LogicalOrExpr: return derived().visitLogicalOrExpr(node);
+                case LogicalAndExpr: return derived().visitLogicalAndExpr(node);
+                case EqualityExpr: return derived().visitEqualityExpr(node);
+                case RelationalExpr: return derived().visitRelationalExpr(node);
+                case AdditiveExpr: return derived().visitAdditiveExpr(node);
+                case MultiplicativeExpr: return derived().visitMultiplicativeExpr(node);
+                case UnaryExpr: return derived().visitUnaryExpr(node);
+                case PostfixExpr: return derived().visitPostfixExpr(node);
+                case ArgList: return derived().visitArgList(node);
+                case ArrayAccess: return derived().visitArrayAccess(node);
+                case ParenthesizedExpr: return derived().visitParenthesizedExpr(node);
+                case TypeSpec: return derived().visitTypeSpec(node);
+                case ArrayType: return derived().visitArrayType(node);
+                case Identifier: return derived().visitIdentifier(node);
+                case LongConst: return derived().visitLongConst(node);
+                case IntConst: return derived().visitIntConst(node);
+                case FloatConst: return derived().visitFloatConst(node);
+                case CharConst: return derived().visitCharConst(node);
+                case StringConst: return derived().visitStringConst(node);
+                case LineComment: return derived().visitLineComment(node);
+                case BlockComment: return derived().visitBlockComment(node);
+                case LazyBody: return derived().visitLazyBody(node);
+                default: return derived().visitNode(node);
+            }
+        }
+    };
+}
+
+#endif //AST_VISITOR_H
@@ -0,0 +1,134 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace parser {
+    // 定长缓冲区输出：攒满一块再整体写出，避免大量细碎的输出调用
+    // 容量按预计输出大小给出时，整个输出只需在最后写出一次
+    // 不关联文件时作为内存缓冲区使用：写满时扩容而不写出，内容由data/size取得
+    // 比较模式下不写出，而是与文件中已有的内容逐块比较，遇到第一个不同的字节后丢弃后续输出
+    class BufferedWriter {
+    public:
+        enum Mode { Write, Compare };
+        explicit BufferedWriter(FILE* out, size_t capacity = 1 << 16) : out(out), buf(capacity), len(0) {}
+        BufferedWriter(FILE* file, Mode mode, size_t capacity = 1 << 16) : BufferedWriter(file, capacity) {
+            comparing = mode == Compare;
+        }
+        BufferedWriter() : BufferedWriter(nullptr) {}
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+        ~BufferedWriter() { flush(); }
+
+        void write(const char* data, size_t n) {
+            if (len + n > buf.size()) {
+                if (!out) {
+                    grow(len + n);
+                } else {
+                    flush();
+                    // 超过整块容量的数据直接写出
+                    if (n > buf.size()) {
+                        emit(data, n);
+                        return;
+                    }
+                }
+            }
+            memcpy(buf.data() + len, data, n);
+            len += n;
+        }
+        void write(const std::string& s) { write(s.data(), s.size()); }
+        void write(const char* s) { write(s, strlen(s)); }
+
+        void put(char c) {
+            if (len == buf.size()) {
+                if (out) flush();
+                else grow(len + 1);
+            }
+            buf[len++] = c;
+        }
+
+        // 输出n个字符c（如缩进用的空格或制表符）
+        void fill(char c, size_t n) {
+            while (n) {
+                if (len == buf.size()) {
+                    if (out) flush();
+                    else grow(len + n);
+                }
+                size_t k = std::min(n, buf.size() - len);
+                memset(buf.data() + len, c, k);
+                len += k;
+                n -= k;
+            }
+        }
+
+        void writeInt(long v) {
+            char tmp[24];
+            int n = 0;
+            unsigned long u = v < 0 ? 0UL - static_cast<unsigned long>(v) : static_cast<unsigned long>(v);
+            do {
+                tmp[n++] = static_cast<char>('0' + u % 10);
+                u /= 10;
+            } while (u);
+            if (v < 0) tmp[n++] = '-';
+            while (n) put(tmp[--n]);
+        }
+
+        const char* data() const { return buf.data(); }
+        size_t size() const { return len; }
+
+        // 写出缓冲区内容，返回此前所有写出是否成功（比较模式下为目前是否都相同）
+        bool flush() {
+            if (len && out) {
+                emit(buf.data(), len);
+                len = 0;
+            }
+            return ok;
+        }
+
+        // 比较模式：全部输出都与文件内容相同，且文件也恰好到此结束
+        bool matchesToEnd() {
+            flush();
+            return ok && fgetc(out) == EOF;
+        }
+        size_t matchedBytes() const { return matched; } // 比较模式下相同的前缀字节数
+        int matchedLines() const { return lines; }      // 相同前缀中的换行数
+
+    private:
+        void emit(const char* data, size_t n) {
+            if (!comparing) {
+                ok = fwrite(data, 1, n, out) == n && ok;
+                return;
+            }
+            char expected[4096];
+            while (ok && n) {
+                size_t k = std::min(n, sizeof(expected));
+                size_t got = fread(expected, 1, k, out);
+                size_t same = 0;
+                if (got == k && memcmp(expected, data, k) == 0) {
+                    same = k;
+                } else {
+                    while (same < got && expected[same] == data[same]) ++same;
+                }
+                matched += same;
+                lines += static_cast<int>(std::count(data, data + same, '\n'));
+                if (same < k) ok = false;
+                data += k;
+                n -= k;
+            }
+        }
+        void grow(size_t need) { buf.resize(std::max(need, buf.size() * 2)); }
+
+        FILE* out;
+        std::vector<char> buf;
+        size_t len;
+        bool ok = true;
+        bool comparing = false;
+        size_t matched = 0;
+        int lines = 0;
+    };
+}
+
+#endif //BUFFERED_WRITER_H
@@ -0,0 +1,54 @@
+#include "expr_pool.h"
+#include <functional>
+
+namespace parser {
+    ExprPool::~ExprPool() {
+        // 子节点同样在池中，先断开再逐个释放，避免析构时访问已释放的子节点
+        for (auto* node : nodes) {
+            node->children.clear();
+            delete node;
+        }
+    }
+
+    uint64_t ExprPool::hashOf(const ASTNode* node) {
+        uint64_t h = std::hash<std::string>()(node->token) ^ (static_cast<uint64_t>(node->type) << 56);
+        for (auto* child : node->children) {
+            h ^= reinterpret_cast<uintptr_t>(child) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+
+    // 子节点已入池，按指针比较即可
+    bool ExprPool::same(const ASTNode* a, const ASTNode* b) {
+        return a->type == b->type && a->token == b->token && a->children == b->children;
+    }
+
+    ASTNode* ExprPool::intern(ASTNode* node) {
+        if (node->shared) return node;
+        for (auto* child : node->children) {
+            if (!child || !child->shared) return node;
+        }
+        uint64_t h = hashOf(node);
+        auto range = table.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (same(it->second, node)) {
+                hits++;
+                delete node; // 子节点都是共享的，不会被一并释放
+                return it->second;
+            }
+        }
+        node->shared = true;
+        table.emplace(h, node);
+        nodes.push_back(node);
+        return node;
+    }
+
+    void ExprPool::adopt(ExprPool& other) {
+        std::lock_guard<std::mutex> lock(adoptLock);
+        for (auto& entry : other.table) table.insert(entry);
+        nodes.insert(nodes.end(), other.nodes.begin(), other.nodes.end());
+        hits += other.hits;
+        other.table.clear();
+        other.nodes.clear();
+    }
+}
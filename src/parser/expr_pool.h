@@ -0,0 +1,41 @@
+#ifndef EXPR_POOL_H
+#define EXPR_POOL_H
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+namespace parser {
+    // 表达式节点的哈希共享（hash-consing）池：类型、token和子节点都相同的表达式只保留一份，AST成为DAG
+    // 池持有其中全部节点，生命周期须覆盖引用它们的AST；共享节点的Token区间是第一次出现处的区间
+    class ExprPool {
+    public:
+        ExprPool() = default;
+        ExprPool(const ExprPool&) = delete;
+        ExprPool& operator=(const ExprPool&) = delete;
+        ~ExprPool();
+
+        // 返回与node等价的共享节点：已有则释放node并返回已有的，否则node入池
+        // 只有全部子节点都已入池的节点才能共享，其余原样返回
+        ASTNode* intern(ASTNode* node);
+        // 接管另一个池（如子解析器的）的全部节点，可多线程调用；不与本池已有的节点去重，
+        // 引用这些节点的AST不必改写，各池内的共享和Token区间保持不变
+        void adopt(ExprPool& other);
+
+        size_t size() const { return nodes.size(); } // 池中节点数
+        size_t reused() const { return hits; }      // 命中已有节点的次数
+
+    private:
+        static uint64_t hashOf(const ASTNode* node);
+        static bool same(const ASTNode* a, const ASTNode* b);
+
+        std::unordered_multimap<uint64_t, ASTNode*> table;
+        std::vector<ASTNode*> nodes;
+        size_t hits = 0;
+        std::mutex adoptLock;
+    };
+}
+
+#endif //EXPR_POOL_H
@@ -0,0 +1,78 @@
+#include "grammar_profile.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace parser {
+    const char* GrammarProfile::ruleName(GrammarRule rule) {
+        static const char* const names[] = {
+#define GRAMMAR_RULE_NAME(name) "parse" #name,
+            GRAMMAR_RULES(GRAMMAR_RULE_NAME)
+#undef GRAMMAR_RULE_NAME
+        };
+        size_t idx = static_cast<size_t>(rule);
+        return idx < RuleCount ? names[idx] : "unknown";
+    }
+
+    void GrammarProfile::merge(const GrammarProfile& other) {
+        std::lock_guard<std::mutex> lock(mergeLock);
+        for (size_t i = 0; i < RuleCount; ++i) {
+            stats[i].calls += other.stats[i].calls;
+            stats[i].matches += other.stats[i].matches;
+            stats[i].rewinds += other.stats[i].rewinds;
+            stats[i].wastedTokens += other.stats[i].wastedTokens;
+            stats[i].nanos += other.stats[i].nanos;
+        }
+    }
+
+    // 被调用过的规则，按耗时降序，耗时相同按调用次数降序
+    static std::vector<size_t> sortedRules(const RuleStats* stats) {
+        std::vector<size_t> order;
+        for (size_t i = 0; i < GrammarProfile::RuleCount; ++i) {
+            if (stats[i].calls) order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [stats](size_t a, size_t b) {
+            if (stats[a].nanos != stats[b].nanos) return stats[a].nanos > stats[b].nanos;
+            return stats[a].calls > stats[b].calls;
+        });
+        return order;
+    }
+
+    void GrammarProfile::printTable(std::ostream& out) const {
+        out << std::left << std::setw(26) << "rule" << std::right
+            << std::setw(12) << "calls" << std::setw(12) << "matches" << std::setw(8) << "match%"
+            << std::setw(10) << "rewinds" << std::setw(12) << "wasted" << std::setw(12) << "incl ms" << "\n";
+        for (size_t i : sortedRules(stats)) {
+            const auto& s = stats[i];
+            out << std::left << std::setw(26) << ruleName(static_cast<GrammarRule>(i)) << std::right
+                << std::setw(12) << s.calls << std::setw(12) << s.matches
+                << std::setw(8) << std::fixed << std::setprecision(1) << 100.0 * s.matches / s.calls
+                << std::setw(10) << s.rewinds << std::setw(12) << s.wastedTokens
+                << std::setw(12) << std::setprecision(3) << s.nanos / 1e6 << "\n";
+        }
+        out.flush();
+    }
+
+    bool GrammarProfile::writeJson(const std::string& filename) const {
+        FILE* file = fopen(filename.c_str(), "w");
+        if (!file) {
+            std::cerr << "Cannot open output file: " << filename << std::endl;
+            return false;
+        }
+        fprintf(file, "{\"rules\":[");
+        bool first = true;
+        for (size_t i : sortedRules(stats)) {
+            const auto& s = stats[i];
+            fprintf(file, "%s\n  {\"rule\":\"%s\",\"calls\":%" PRIu64 ",\"matches\":%" PRIu64
+                          ",\"rewinds\":%" PRIu64 ",\"wastedTokens\":%" PRIu64 ",\"inclusiveNs\":%" PRIu64 "}",
+                    first ? "" : ",", ruleName(static_cast<GrammarRule>(i)),
+                    s.calls, s.matches, s.rewinds, s.wastedTokens, s.nanos);
+            first = false;
+        }
+        fprintf(file, "\n]}\n");
+        return fclose(file) == 0;
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef GRAMMAR_PROFILE_H
+#define GRAMMAR_PROFILE_H
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace parser {
+    // 与 llparse_*.cpp 中的 parse* 方法一一对应
+#define GRAMMAR_RULES(X) \
+    X(Program) X(ExternalDeclList) X(ExternalDecl) \
+    X(VarDecl) X(LocalVarDecl) \
+    X(FunctionDecl) X(FunctionDef) X(ParamList) X(ParamListTail) X(Param) \
+    X(CompoundStmt) X(StmtList) \
+    X(Stmt) X(ExprStmt) X(IfStmt) X(WhileStmt) X(ForStmt) X(ReturnStmt) X(BreakStmt) X(ContinueStmt) \
+    X(Expr) X(AssignExpr) X(LogicalOrExpr) X(LogicalAndExpr) X(EqualityExpr) X(RelationalExpr) \
+    X(AdditiveExpr) X(MultiplicativeExpr) X(UnaryExpr) X(PostfixExpr) X(ArgList) X(PrimaryExpr) \
+    X(TypeSpec)
+
+    enum class GrammarRule {
+#define GRAMMAR_RULE_ENUM(name) name,
+        GRAMMAR_RULES(GRAMMAR_RULE_ENUM)
+#undef GRAMMAR_RULE_ENUM
+        Count
+    };
+
+    // 单条文法规则的统计
+    struct RuleStats {
+        uint64_t calls = 0;        // 调用次数
+        uint64_t matches = 0;      // 成功匹配（正常返回且越过了入口位置）的次数，抛出ParseError退出的不算
+        uint64_t rewinds = 0;      // 本规则内回溯（pos = backup 且确实后退）的次数
+        uint64_t wastedTokens = 0; // 回溯时丢弃的、已经消耗过的Token数
+        uint64_t nanos = 0;        // 含子规则的总耗时，递归调用只计最外层
+        int active = 0;            // 当前递归深度
+    };
+
+    // 文法规则剖析：记录每个 parse* 方法的调用、匹配、回溯和耗时
+    class GrammarProfile {
+    public:
+        static constexpr size_t RuleCount = static_cast<size_t>(GrammarRule::Count);
+        static const char* ruleName(GrammarRule rule);
+
+        RuleStats stats[RuleCount];
+        int current = -1; // 正在执行的最内层规则，回溯计入该规则
+
+        // 从pos回溯了count个Token
+        void rewind(int count) {
+            if (current < 0) return;
+            stats[current].rewinds++;
+            stats[current].wastedTokens += count;
+        }
+        // 合并子解析器（可能在其他线程）的统计
+        void merge(const GrammarProfile& other);
+        // 按耗时降序输出表格
+        void printTable(std::ostream& out) const;
+        bool writeJson(const std::string& filename) const;
+
+    private:
+        std::mutex mergeLock;
+    };
+
+    // 在 parse* 方法入口构造，退出时记录匹配结果与耗时；因异常展开而析构时即使已消耗Token也算匹配失败
+    // profile为空时不做任何事
+    class RuleScope {
+    public:
+        RuleScope(GrammarProfile* profile, GrammarRule rule, const int& pos)
+            : profile(profile), rule(static_cast<int>(rule)), pos(pos), entry(pos) {
+            if (!profile) return;
+            auto& s = profile->stats[this->rule];
+            s.calls++;
+            outermost = s.active++ == 0;
+            previous = profile->current;
+            profile->current = this->rule;
+            if (outermost) start = std::chrono::steady_clock::now();
+        }
+        ~RuleScope() {
+            if (!profile) return;
+            auto& s = profile->stats[rule];
+            if (pos > entry && !std::uncaught_exception()) s.matches++;
+            s.active--;
+            profile->current = previous;
+            if (outermost) {
+                s.nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        RuleScope(const RuleScope&) = delete;
+        RuleScope& operator=(const RuleScope&) = delete;
+
+    private:
+        GrammarProfile* profile;
+        int rule;
+        const int& pos;
+        int entry;
+        int previous = -1;
+        bool outermost = false;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#endif //GRAMMAR_PROFILE_H
@@ -0,0 +1,265 @@
+#include "ast.h"
+#include "parser.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <unordered_map>
+
+namespace parser {
+    SourceEdit SourceEdit::between(const std::string& before, const std::string& after) {
+        size_t common = std::min(before.size(), after.size());
+        size_t prefix = 0;
+        while (prefix < common && before[prefix] == after[prefix]) prefix++;
+        size_t suffix = 0;
+        while (suffix < common - prefix && before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+            suffix++;
+        }
+        return SourceEdit{prefix, before.size() - prefix - suffix, after.substr(prefix, after.size() - prefix - suffix)};
+    }
+
+    // 一段Token的FNV-1a哈希，只看种类和文本，声明整体平移时哈希不变
+    static uint64_t hashTokens(const lexer::Token* first, const lexer::Token* last) {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](unsigned char c) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        };
+        for (; first != last; ++first) {
+            mix(static_cast<unsigned char>(first->kind));
+            for (char c : first->text) mix(static_cast<unsigned char>(c));
+            mix(0xff); // Token分隔，避免 "ab" "c" 与 "a" "bc" 相撞
+        }
+        return h;
+    }
+
+    static bool sameTokens(const lexer::Token* a, const lexer::Token* b, int count) {
+        for (int i = 0; i < count; ++i) {
+            if (a[i].kind != b[i].kind || a[i].text != b[i].text) return false;
+        }
+        return true;
+    }
+
+    // 子树整体平移delta个Token；共享的表达式节点可能被多处引用，区间不随某一处平移
+    static void shiftSpans(ASTNode* node, int delta) {
+        if (node->shared) return;
+        if (node->firstToken >= 0) {
+            node->firstToken += delta;
+            node->lastToken += delta;
+        }
+        for (auto* child : node->children) shiftSpans(child, delta);
+    }
+
+    ASTNode* Parser::parseSource(std::string text) {
+        debugLog("parseSource", pos);
+        delete root; // 各段的声明都挂在root下，一并释放
+        root = nullptr;
+        topLevel.clear();
+        diagnostics.clear();
+        source = std::move(text);
+        lexer::Lexer lex(source.data(), source.size());
+        tokens = lex.tokenize();
+        pos = 0;
+        if (hashCons && !exprPool) exprPool.reset(new ExprPool);
+        auto ranges = splitTopLevel();
+        std::vector<std::vector<ASTNode*>> results;
+        std::vector<std::vector<Diagnostic>> rangeDiags;
+        parseRanges(ranges, results, rangeDiags);
+        topLevel.reserve(ranges.size());
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            int begin = ranges[i].first;
+            int end = ranges[i].second;
+            topLevel.push_back(TopLevelEntry{begin, end, hashTokens(tokens.data() + begin, tokens.data() + end),
+                                             std::move(results[i]), std::move(rangeDiags[i])});
+        }
+        incremental = true;
+        return assembleTopLevel();
+    }
+
+    // 按topLevel重建声明列表和诊断，Program和ExternalDeclList节点沿用已有的
+    ASTNode* Parser::assembleTopLevel() {
+        if (!root) {
+            root = new ASTNode{NodeType::Program};
+            root->children.push_back(new ASTNode{NodeType::ExternalDeclList});
+        }
+        auto* declList = root->children[0];
+        declList->children.clear();
+        diagnostics.clear();
+        for (auto& entry : topLevel) {
+            declList->children.insert(declList->children.end(), entry.decls.begin(), entry.decls.end());
+            diagnostics.insert(diagnostics.end(), entry.diagnostics.begin(), entry.diagnostics.end());
+        }
+        pos = topLevel.empty() ? 0 : topLevel.back().end;
+        span(root, 0);
+        span(declList, 0);
+        if (declList->children.empty() && diagnostics.empty()) {
+            report("program: expected at least one external declaration");
+        }
+        return root;
+    }
+
+    ASTNode* Parser::reparse(const SourceEdit& edit) {
+        debugLog("reparse", pos);
+        if (!incremental || edit.offset > source.size() || edit.removed > source.size() - edit.offset) return nullptr;
+        lastReparse = ReparseStats{};
+        auto startOf = [this](const TopLevelEntry& entry) { return tokens[entry.begin].offset; };
+
+        // 从起点不晚于编辑处的最后一段重新分析；未闭合块注释的错误Token记的是结束处的行号，不能作为起点
+        size_t first = std::upper_bound(topLevel.begin(), topLevel.end(), edit.offset,
+                                        [&](size_t offset, const TopLevelEntry& entry) {
+                                            return offset < startOf(entry);
+                                        }) - topLevel.begin();
+        first = first > 0 ? first - 1 : 0;
+        while (first > 0 && tokens[topLevel[first].begin].kind == lexer::TokenKind::ERROR_TOKEN) first--;
+        size_t restart = 0;
+        int line = 1;
+        int column = 0;
+        int oldBegin = 0;
+        if (first < topLevel.size() && startOf(topLevel[first]) <= edit.offset &&
+            tokens[topLevel[first].begin].kind != lexer::TokenKind::ERROR_TOKEN) {
+            const auto& token = tokens[topLevel[first].begin];
+            restart = token.offset;
+            line = token.line;
+            column = token.column - 1;
+            oldBegin = topLevel[first].begin;
+        }
+
+        ptrdiff_t delta = static_cast<ptrdiff_t>(edit.inserted.size()) - static_cast<ptrdiff_t>(edit.removed);
+        size_t editEnd = edit.offset + edit.inserted.size(); // 编辑后的内容在新源码中的结束处
+        source.replace(edit.offset, edit.removed, edit.inserted);
+
+        // 逐个读Token并按顶层声明切分。越过编辑处以后，每到段边界就看该处在旧源码中是否也是某段的起点：
+        // 是则此后的字节与旧源码相同、词法状态也相同，旧Token可以原样沿用，到此为止
+        lexer::Lexer lex(source.data(), source.size(), restart, line, column);
+        std::vector<lexer::Token> window;
+        std::vector<std::pair<int, int>> ranges; // window中各段的区间
+        TopLevelSplitter splitter;
+        size_t resume = topLevel.size(); // 对齐处的旧段下标，未对齐时为段数
+        lexer::Token anchor{};           // 对齐处的新Token
+        bool boundary = true;
+        int rangeStart = 0;
+        for (;;) {
+            lexer::Token token = lex.next();
+            auto kind = token.kind;
+            if (boundary && token.offset >= editEnd && kind != lexer::TokenKind::EOF_TOKEN &&
+                kind != lexer::TokenKind::ERROR_TOKEN) {
+                size_t oldOffset = token.offset - delta;
+                auto it = std::lower_bound(topLevel.begin() + first, topLevel.end(), oldOffset,
+                                           [&](const TopLevelEntry& entry, size_t offset) {
+                                               return startOf(entry) < offset;
+                                           });
+                if (it != topLevel.end() && startOf(*it) == oldOffset) {
+                    resume = it - topLevel.begin();
+                    anchor = std::move(token);
+                    break;
+                }
+            }
+            window.push_back(std::move(token));
+            if (kind == lexer::TokenKind::EOF_TOKEN || kind == lexer::TokenKind::ERROR_TOKEN) break;
+            boundary = splitter.feed(kind);
+            if (boundary) {
+                ranges.emplace_back(rangeStart, (int)window.size());
+                rangeStart = (int)window.size();
+            }
+        }
+        if (resume == topLevel.size()) {
+            // 读到了末尾：不完整的声明单独成段，词法错误Token留在段内（同splitTopLevel）
+            int tail = window.back().kind == lexer::TokenKind::EOF_TOKEN ? (int)window.size() - 1 : (int)window.size();
+            if (rangeStart < tail) ranges.emplace_back(rangeStart, tail);
+        }
+        lastReparse.relexedBytes = (resume < topLevel.size() ? anchor.offset : source.size()) - restart;
+        int oldEnd = resume < topLevel.size() ? topLevel[resume].begin : (int)tokens.size();
+        int tokenDelta = (int)window.size() - (oldEnd - oldBegin);
+
+        // 新段先按内容哈希在被覆盖的旧段中找相同的，找到即复用原子树（顶层声明移动、被复制或段边界变化时）
+        std::unordered_multimap<uint64_t, size_t> candidates;
+        for (size_t i = first; i < resume; ++i) candidates.emplace(topLevel[i].hash, i);
+        std::vector<TopLevelEntry> fresh(ranges.size());
+        std::vector<std::pair<int, int>> reparseRanges;
+        std::vector<size_t> reparseIndex;
+        for (size_t r = 0; r < ranges.size(); ++r) {
+            auto& entry = fresh[r];
+            int length = ranges[r].second - ranges[r].first;
+            entry.begin = oldBegin + ranges[r].first;
+            entry.end = oldBegin + ranges[r].second;
+            entry.hash = hashTokens(window.data() + ranges[r].first, window.data() + ranges[r].second);
+            auto match = candidates.equal_range(entry.hash);
+            auto it = match.first;
+            for (; it != match.second; ++it) {
+                const auto& old = topLevel[it->second];
+                if (old.end - old.begin == length &&
+                    sameTokens(tokens.data() + old.begin, window.data() + ranges[r].first, length)) {
+                    break;
+                }
+            }
+            if (it == match.second) {
+                reparseRanges.emplace_back(entry.begin, entry.end);
+                reparseIndex.push_back(r);
+                continue;
+            }
+            auto& old = topLevel[it->second];
+            int shift = entry.begin - old.begin;
+            if (shift != 0) {
+                for (auto* decl : old.decls) shiftSpans(decl, shift);
+                for (auto& diag : old.diagnostics) diag.token += shift;
+            }
+            entry.decls = std::move(old.decls);
+            entry.diagnostics = std::move(old.diagnostics);
+            candidates.erase(it);
+        }
+        // 没有被复用的旧子树释放
+        for (size_t i = first; i < resume; ++i) {
+            for (auto* decl : topLevel[i].decls) delete decl;
+        }
+
+        // 对齐处之后的旧Token字节偏移和行号整体平移，与对齐处同一行的还要平移列号，再换入新读的Token
+        if (resume < topLevel.size()) {
+            int anchorLine = tokens[oldEnd].line;
+            int lineDelta = anchor.line - anchorLine;
+            int columnDelta = anchor.column - tokens[oldEnd].column;
+            for (size_t i = oldEnd; i < tokens.size(); ++i) {
+                auto& token = tokens[i];
+                token.offset += delta;
+                if (token.line == anchorLine) token.column += columnDelta;
+                token.line += lineDelta;
+            }
+        }
+        // 新旧Token数相同的部分就地替换，只有多出或少掉的部分需要移动之后的Token
+        int common = std::min((int)window.size(), oldEnd - oldBegin);
+        std::move(window.begin(), window.begin() + common, tokens.begin() + oldBegin);
+        if (tokenDelta < 0) {
+            tokens.erase(tokens.begin() + oldBegin + common, tokens.begin() + oldEnd);
+        } else if (tokenDelta > 0) {
+            tokens.insert(tokens.begin() + oldEnd, std::make_move_iterator(window.begin() + common),
+                          std::make_move_iterator(window.end()));
+        }
+
+        std::vector<std::vector<ASTNode*>> results;
+        std::vector<std::vector<Diagnostic>> rangeDiags;
+        parseRanges(reparseRanges, results, rangeDiags);
+        for (size_t k = 0; k < reparseIndex.size(); ++k) {
+            fresh[reparseIndex[k]].decls = std::move(results[k]);
+            fresh[reparseIndex[k]].diagnostics = std::move(rangeDiags[k]);
+        }
+        // 之后的各段只平移Token下标
+        for (size_t i = resume; i < topLevel.size() && tokenDelta != 0; ++i) {
+            auto& entry = topLevel[i];
+            entry.begin += tokenDelta;
+            entry.end += tokenDelta;
+            for (auto* decl : entry.decls) shiftSpans(decl, tokenDelta);
+            for (auto& diag : entry.diagnostics) diag.token += tokenDelta;
+        }
+        topLevel.erase(topLevel.begin() + first, topLevel.begin() + resume);
+        topLevel.insert(topLevel.begin() + first, std::make_move_iterator(fresh.begin()),
+                        std::make_move_iterator(fresh.end()));
+
+        lastReparse.reparsedRanges = reparseRanges.size();
+        lastReparse.reusedRanges = topLevel.size() - reparseRanges.size();
+        if (debug) {
+            std::cout << "[DEBUG] reparse: re-lexed " << lastReparse.relexedBytes << " bytes, reparsed "
+                      << lastReparse.reparsedRanges << ", reused " << lastReparse.reusedRanges
+                      << " top-level ranges" << std::endl;
+        }
+        debugLog("reparse_exit", pos);
+        return assembleTopLevel();
+    }
+}
@@ -0,0 +1,101 @@
+#include "ast.h"
+#include "parser.h"
+#include "translater.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+namespace parser {
+    // 从open处的 '{' 开始按括号深度找到与之匹配的 '}'，找不到返回-1
+    int Parser::matchBrace(int open) const {
+        if (open >= (int)tokens.size() || tokens[open].kind != lexer::TokenKind::LC) return -1;
+        int depth = 0;
+        for (int i = open; i < (int)tokens.size(); ++i) {
+            auto kind = tokens[i].kind;
+            if (kind == lexer::TokenKind::LC) {
+                depth++;
+            } else if (kind == lexer::TokenKind::RC) {
+                if (--depth == 0) return i;
+            } else if (kind == lexer::TokenKind::EOF_TOKEN) {
+                break;
+            }
+        }
+        return -1;
+    }
+
+    // 就地把LazyBody占位节点解析为复合语句，指向该节点的指针保持有效
+    void Parser::expandBody(ASTNode* node) {
+        debugLog("expandBody", pos);
+        int saved = pos;
+        // 先把已有诊断移开，解析完只输出本函数体的，再按位置归并回去
+        std::vector<Diagnostic> earlier;
+        earlier.swap(diagnostics);
+        pos = node->firstToken - tokenBase;
+        ASTNode* parsed = nullptr;
+        try {
+            parsed = parseCompoundStmt();
+            if (!parsed || pos != node->lastToken - tokenBase + 1) error("function body: expected compound statement");
+        } catch (const ParseError&) {
+            // 函数体无法恢复时退化为空的复合语句
+            delete parsed;
+            parsed = span(new ASTNode{NodeType::CompoundStmt}, node->firstToken - tokenBase);
+            parsed->lastToken = node->lastToken;
+        }
+        node->type = parsed->type;
+        node->children.swap(parsed->children);
+        delete parsed;
+        pos = saved;
+        printDiagnostics();
+        std::vector<Diagnostic> merged;
+        merged.reserve(earlier.size() + diagnostics.size());
+        std::merge(std::make_move_iterator(earlier.begin()), std::make_move_iterator(earlier.end()),
+                   std::make_move_iterator(diagnostics.begin()), std::make_move_iterator(diagnostics.end()),
+                   std::back_inserter(merged),
+                   [](const Diagnostic& a, const Diagnostic& b) { return a.token < b.token; });
+        diagnostics.swap(merged);
+    }
+
+    ASTNode* Parser::body(ASTNode* funcDef) {
+        if (!funcDef || funcDef->type != NodeType::FunctionDef || funcDef->children.empty()) return nullptr;
+        ASTNode* node = funcDef->children.back();
+        if (node->type == NodeType::LazyBody) expandBody(node);
+        return node;
+    }
+
+    void Parser::expandBodies() {
+        if (!root || root->children.empty()) return;
+        for (auto* decl : root->children[0]->children) {
+            body(decl);
+        }
+    }
+
+    // 每个顶层声明一行：行:列、声明种类、类型和名字
+    void Parser::outputSymbols(std::string& filename) {
+        if (filename.empty()) {
+            filename = "symbols.txt";
+        }
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Cannot open output file: " << filename << std::endl;
+            return;
+        }
+        if (!root) {
+            std::cerr << "No AST to output." << std::endl;
+            return;
+        }
+        for (auto* decl : root->children[0]->children) {
+            if (decl->type != NodeType::FunctionDef && decl->type != NodeType::FunctionDecl &&
+                decl->type != NodeType::VarDecl) {
+                continue;
+            }
+            const auto* name = decl->children[1];
+            if (name->firstToken >= 0 && name->firstToken < (int)tokens.size()) {
+                out << tokens[name->firstToken].line << ":" << tokens[name->firstToken].column;
+            }
+            out << "\t" << getNodeTypeCNString(decl->type) << "\t"
+                << decl->children[0]->token << " " << name->token << "\n";
+        }
+        out.close();
+    }
+}
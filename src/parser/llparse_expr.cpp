@@ -3,9 +3,30 @@
 #include "token_translater.h"
 
 namespace parser {
+    // 左结合的二元运算：默认每个运算符一个二元节点；
+    // flatChains时同一优先级的整条链合为一个n元节点，运算符名依次以空格分隔存入token，
+    // 第i个运算符位于children[i]与children[i+1]之间。链在构造完成后才能入共享池
+    ASTNode* Parser::chainNode(NodeType type, ASTNode* left, const std::string& op, ASTNode* right, int start) {
+        // 链的第一个操作数来自更高优先级，类型不会相同，相同即是正在构造的链
+        if (flatChains && left->type == type) {
+            if (!op.empty()) {
+                left->token += ' ';
+                left->token += op;
+            }
+            left->children.push_back(right);
+            return span(left, start);
+        }
+        auto* node = span(new ASTNode{type}, start);
+        node->token = op;
+        node->children.push_back(left);
+        node->children.push_back(right);
+        return flatChains ? node : intern(node);
+    }
+
     // expr → assign_expr
     ASTNode* Parser::parseExpr() {
         debugLog("parseExpr", pos);
+        RuleScope scope(profile, GrammarRule::Expr, pos);
         ASTNode* node = parseAssignExpr();
         debugLog("parseExpr_exit", pos);
         return node;
@@ -14,6 +35,7 @@ namespace parser {
     // assign_expr → logical_or_expr | IDENT ASSIGN assign_expr
     ASTNode* Parser::parseAssignExpr() {
         debugLog("parseAssignExpr", pos);
+        RuleScope scope(profile, GrammarRule::AssignExpr, pos);
         int backup = pos;
         // 检查是否为赋值表达式 IDENT ASSIGN assign_expr
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::IDENT) {
@@ -25,180 +47,163 @@ namespace parser {
                 ASTNode* rhs = parseAssignExpr();
                 if (!rhs) {
                     error("assign_expr: expected expression after '='");
-                    pos = backup;
-                    return nullptr;
                 }
-                auto* node = new ASTNode{NodeType::AssignExpr};
-                auto* identNode = new ASTNode{NodeType::Identifier};
+                auto* node = span(new ASTNode{NodeType::AssignExpr}, backup);
+                auto* identNode = spanAt(new ASTNode{NodeType::Identifier}, identPos);
                 identNode->token = ident;
-                node->children.push_back(identNode);
+                node->children.push_back(intern(identNode));
                 node->children.push_back(rhs);
-                return node;
+                return intern(node);
             } else {
-                pos = identPos; // 回溯，仅IDENT不是赋值
+                rewind(identPos); // 回溯，仅IDENT不是赋值
             }
         }
         // 否则为逻辑或表达式
-        pos = backup;
+        rewind(backup);
         return parseLogicalOrExpr();
     }
 
     // logical_or_expr → logical_and_expr { OR logical_and_expr }
     ASTNode* Parser::parseLogicalOrExpr() {
         debugLog("parseLogicalOrExpr", pos);
-        ASTNode* left = parseLogicalAndExpr();
+        RuleScope scope(profile, GrammarRule::LogicalOrExpr, pos);
+        int start = pos;
+        NodePtr left(parseLogicalAndExpr());
         if (!left) return nullptr;
         while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::OR) {
             pos++;
-            ASTNode* right = parseLogicalAndExpr();
+            NodePtr right(parseLogicalAndExpr());
             if (!right) {
                 error("logical_or_expr: expected expression after '||'");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::LogicalOrExpr};
-            node->children.push_back(left);
-            node->children.push_back(right);
-            left = node;
+            left.reset(chainNode(NodeType::LogicalOrExpr, left.release(), std::string(), right.release(), start));
         }
         debugLog("parseLogicalOrExpr_exit", pos);
-        return left;
+        return intern(left.release());
     }
 
     // logical_and_expr → equality_expr { AND equality_expr }
     ASTNode* Parser::parseLogicalAndExpr() {
         debugLog("parseLogicalAndExpr", pos);
-        ASTNode* left = parseEqualityExpr();
+        RuleScope scope(profile, GrammarRule::LogicalAndExpr, pos);
+        int start = pos;
+        NodePtr left(parseEqualityExpr());
         if (!left) return nullptr;
         while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::AND) {
             pos++;
-            ASTNode* right = parseEqualityExpr();
+            NodePtr right(parseEqualityExpr());
             if (!right) {
                 error("logical_and_expr: expected expression after '&&'");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::LogicalAndExpr};
-            node->children.push_back(left);
-            node->children.push_back(right);
-            left = node;
+            left.reset(chainNode(NodeType::LogicalAndExpr, left.release(), std::string(), right.release(), start));
         }
         debugLog("parseLogicalAndExpr_exit", pos);
-        return left;
+        return intern(left.release());
     }
 
     // equality_expr → relational_expr { (EQ | NEQ) relational_expr }
     ASTNode* Parser::parseEqualityExpr() {
         debugLog("parseEqualityExpr", pos);
-        ASTNode* left = parseRelationalExpr();
+        RuleScope scope(profile, GrammarRule::EqualityExpr, pos);
+        int start = pos;
+        NodePtr left(parseRelationalExpr());
         if (!left) return nullptr;
         while (pos < tokens.size() &&
                (tokens[pos].kind == lexer::TokenKind::EQ || tokens[pos].kind == lexer::TokenKind::NEQ)) {
             auto op = tokens[pos].kind;
             pos++;
-            ASTNode* right = parseRelationalExpr();
+            NodePtr right(parseRelationalExpr());
             if (!right) {
                 error("equality_expr: expected expression after '==' or '!='");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::EqualityExpr};
-            node->token = lexer::TokenKindToString(op);
-            node->children.push_back(left);
-            node->children.push_back(right);
-            left = node;
+            left.reset(chainNode(NodeType::EqualityExpr, left.release(), lexer::TokenKindToString(op), right.release(), start));
         }
         debugLog("parseEqualityExpr_exit", pos);
-        return left;
+        return intern(left.release());
     }
 
     // relational_expr → additive_expr { (LT | GT | LE | GE) additive_expr }
     ASTNode* Parser::parseRelationalExpr() {
         debugLog("parseRelationalExpr", pos);
-        ASTNode* left = parseAdditiveExpr();
+        RuleScope scope(profile, GrammarRule::RelationalExpr, pos);
+        int start = pos;
+        NodePtr left(parseAdditiveExpr());
         if (!left) return nullptr;
         while (pos < tokens.size() &&
                (tokens[pos].kind == lexer::TokenKind::LT || tokens[pos].kind == lexer::TokenKind::GT ||
                 tokens[pos].kind == lexer::TokenKind::LE || tokens[pos].kind == lexer::TokenKind::GE)) {
             auto op = tokens[pos].kind;
             pos++;
-            ASTNode* right = parseAdditiveExpr();
+            NodePtr right(parseAdditiveExpr());
             if (!right) {
                 error("relational_expr: expected expression after '<', '>', '<=', '>='");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::RelationalExpr};
-            node->token = lexer::TokenKindToString(op);
-            node->children.push_back(left);
-            node->children.push_back(right);
-            left = node;
+            left.reset(chainNode(NodeType::RelationalExpr, left.release(), lexer::TokenKindToString(op), right.release(), start));
         }
         debugLog("parseRelationalExpr_exit", pos);
-        return left;
+        return intern(left.release());
     }
 
     // additive_expr → multiplicative_expr { (PLUS | MINUS) multiplicative_expr }
     ASTNode* Parser::parseAdditiveExpr() {
         debugLog("parseAdditiveExpr", pos);
-        ASTNode* left = parseMultiplicativeExpr();
+        RuleScope scope(profile, GrammarRule::AdditiveExpr, pos);
+        int start = pos;
+        NodePtr left(parseMultiplicativeExpr());
         if (!left) return nullptr;
         while (pos < tokens.size() &&
                (tokens[pos].kind == lexer::TokenKind::PLUS || tokens[pos].kind == lexer::TokenKind::MINUS)) {
             auto op = tokens[pos].kind;
             pos++;
-            ASTNode* right = parseMultiplicativeExpr();
+            NodePtr right(parseMultiplicativeExpr());
             if (!right) {
                 error("additive_expr: expected expression after '+' or '-'");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::AdditiveExpr};
-            node->token = lexer::TokenKindToString(op);
-            node->children.push_back(left);
-            node->children.push_back(right);
-            left = node;
+            left.reset(chainNode(NodeType::AdditiveExpr, left.release(), lexer::TokenKindToString(op), right.release(), start));
         }
         debugLog("parseAdditiveExpr_exit", pos);
-        return left;
+        return intern(left.release());
     }
 
     // multiplicative_expr → unary_expr { (MUL | DIV | MOD) unary_expr }
     ASTNode* Parser::parseMultiplicativeExpr() {
         debugLog("parseMultiplicativeExpr", pos);
-        ASTNode* left = parseUnaryExpr();
+        RuleScope scope(profile, GrammarRule::MultiplicativeExpr, pos);
+        int start = pos;
+        NodePtr left(parseUnaryExpr());
         if (!left) return nullptr;
         while (pos < tokens.size() &&
                (tokens[pos].kind == lexer::TokenKind::MUL || tokens[pos].kind == lexer::TokenKind::DIV || tokens[pos].kind == lexer::TokenKind::MOD)) {
             auto op = tokens[pos].kind;
             pos++;
-            ASTNode* right = parseUnaryExpr();
+            NodePtr right(parseUnaryExpr());
             if (!right) {
                 error("multiplicative_expr: expected expression after '*', '/' or '%'");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::MultiplicativeExpr};
-            node->token = lexer::TokenKindToString(op);
-            node->children.push_back(left);
-            node->children.push_back(right);
-            left = node;
+            left.reset(chainNode(NodeType::MultiplicativeExpr, left.release(), lexer::TokenKindToString(op), right.release(), start));
         }
         debugLog("parseMultiplicativeExpr_exit", pos);
-        return left;
+        return intern(left.release());
     }
 
     // unary_expr → (PLUS | MINUS | NOT) unary_expr | postfix_expr
     ASTNode* Parser::parseUnaryExpr() {
         debugLog("parseUnaryExpr", pos);
+        RuleScope scope(profile, GrammarRule::UnaryExpr, pos);
         if (pos < tokens.size() &&
             (tokens[pos].kind == lexer::TokenKind::PLUS || tokens[pos].kind == lexer::TokenKind::MINUS || tokens[pos].kind == lexer::TokenKind::NOT)) {
+            int start = pos;
             auto op = tokens[pos].kind;
             pos++;
-            ASTNode* expr = parseUnaryExpr();
+            NodePtr expr(parseUnaryExpr());
             if (!expr) {
                 error("unary_expr: expected expression after unary operator");
-                return nullptr;
             }
-            auto* node = new ASTNode{NodeType::UnaryExpr};
+            auto* node = span(new ASTNode{NodeType::UnaryExpr}, start);
             node->token = lexer::TokenKindToString(op);
-            node->children.push_back(expr);
+            node->children.push_back(expr.release());
             debugLog("parseUnaryExpr_exit", pos);
-            return node;
+            return intern(node);
         }
         return parsePostfixExpr();
     }
@@ -206,6 +211,7 @@ namespace parser {
     // postfix_expr → primary_expr | IDENT LP arg_list RP | postfix_expr LB expr RB
     ASTNode* Parser::parsePostfixExpr() {
         debugLog("parsePostfixExpr", pos);
+        RuleScope scope(profile, GrammarRule::PostfixExpr, pos);
         int backup = pos;
         // 检查是否为函数调用 IDENT LP arg_list RP
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::IDENT) {
@@ -214,112 +220,104 @@ namespace parser {
             pos++;
             if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LP) {
                 pos++;
-                ASTNode* args = parseArgList();
+                NodePtr args(parseArgList());
                 if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
                     error("postfix_expr: expected ')' after function call arguments");
-                    pos = backup;
-                    return nullptr;
                 }
                 pos++;
-                auto* node = new ASTNode{NodeType::PostfixExpr};
-                auto* identNode = new ASTNode{NodeType::Identifier};
+                auto* node = span(new ASTNode{NodeType::PostfixExpr}, backup);
+                auto* identNode = spanAt(new ASTNode{NodeType::Identifier}, identPos);
                 identNode->token = ident;
-                node->children.push_back(identNode);
-                if (args) node->children.push_back(args);
+                node->children.push_back(intern(identNode));
+                if (args) node->children.push_back(args.release());
                 debugLog("parsePostfixExpr_exit", pos);
-                return node;
+                return intern(node);
             } else {
-                pos = identPos; // 不是函数调用，回溯
+                rewind(identPos); // 不是函数调用，回溯
             }
         }
         // 数组访问：postfix_expr LB expr RB
-        ASTNode* base = nullptr;
         int arrBackup = pos;
-        base = parsePrimaryExpr();
+        NodePtr base(parsePrimaryExpr());
         if (!base) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LB) {
             pos++;
-            ASTNode* indexExpr = parseExpr();
+            NodePtr indexExpr(parseExpr());
             if (!indexExpr) {
                 error("array_access: expected expression inside []");
-                pos = arrBackup;
-                return nullptr;
             }
             if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RB) {
                 error("array_access: expected ']' after expression");
-                pos = arrBackup;
-                return nullptr;
             }
             pos++;
-            auto* arrNode = new ASTNode{NodeType::ArrayAccess};
-            arrNode->children.push_back(base);
-            arrNode->children.push_back(indexExpr);
-            base = arrNode;
+            auto* arrNode = span(new ASTNode{NodeType::ArrayAccess}, arrBackup);
+            arrNode->children.push_back(base.release());
+            arrNode->children.push_back(indexExpr.release());
+            base.reset(intern(arrNode));
         }
         debugLog("parsePostfixExpr_exit", pos);
-        return base;
+        return base.release();
     }
 
     // arg_list → expr { COMMA expr } | ε
     ASTNode* Parser::parseArgList() {
         debugLog("parseArgList", pos);
+        RuleScope scope(profile, GrammarRule::ArgList, pos);
         int backup = pos;
         ASTNode* first = parseExpr();
         if (!first) return nullptr; // ε
-        auto* node = new ASTNode{NodeType::ArgList};
+        NodePtr node(span(new ASTNode{NodeType::ArgList}, backup));
         node->children.push_back(first);
         while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::COMMA) {
             pos++;
             ASTNode* arg = parseExpr();
             if (!arg) {
                 error("arg_list: expected expression after ','");
-                pos = backup;
-                return nullptr;
             }
             node->children.push_back(arg);
         }
         debugLog("parseArgList_exit", pos);
-        return node;
+        return intern(span(node.release(), backup));
     }
 
     // primary_expr → IDENT | LONG_CONST | INT_CONST | FLOAT_CONST | CHAR_CONST | STRING_CONST | LP expr RP
     ASTNode* Parser::parsePrimaryExpr() {
         debugLog("parsePrimaryExpr", pos);
+        RuleScope scope(profile, GrammarRule::PrimaryExpr, pos);
         if (pos >= tokens.size()) return nullptr;
         auto kind = tokens[pos].kind;
         auto nodeType = getTypeFromTokenKind(kind);
         if (kind == lexer::TokenKind::IDENT) {
-            auto* node = new ASTNode{NodeType::Identifier};
+            auto* node = spanAt(new ASTNode{NodeType::Identifier}, pos);
             node->token = tokens[pos].text;
             pos++;
             debugLog("parsePrimaryExpr_exit", pos);
-            return node;
+            return intern(node);
         } else if (isTerminalNode(nodeType)) {
-            auto* node = new ASTNode{nodeType};
+            auto* node = spanAt(new ASTNode{nodeType}, pos);
             node->token = tokens[pos].text;
             pos++;
             debugLog("parsePrimaryExpr_exit", pos);
-            return node;
+            return intern(node);
         } else if (kind == lexer::TokenKind::LP) {
+            int start = pos;
             pos++;
-            ASTNode* expr = parseExpr();
+            NodePtr expr(parseExpr());
             if (!expr) {
                 error("primary_expr: expected expression after '('");
-                return nullptr;
             }
             if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
                 error("primary_expr: expected ')' after expression");
-                return nullptr;
             }
             pos++;
             // 生成 ParenthesizedExpr 节点
-            auto* node = new ASTNode{NodeType::ParenthesizedExpr};
-            node->children.push_back(expr);
+            auto* node = span(new ASTNode{NodeType::ParenthesizedExpr}, start);
+            node->children.push_back(expr.release());
             debugLog("parsePrimaryExpr_exit", pos);
-            return node;
+            return intern(node);
         }
         return nullptr;
     }
@@ -5,43 +5,45 @@ namespace parser {
     // 函数声明：type_spec IDENT LP param_list RP SEMI
     ASTNode *Parser::parseFunctionDecl() {
         debugLog("parseFunctionDecl", pos);
+        RuleScope scope(profile, GrammarRule::FunctionDecl, pos);
         int backup = pos;
-        ASTNode* typeNode = parseTypeSpec();
+        NodePtr typeNode(parseTypeSpec());
         if (!typeNode) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::IDENT) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
-        auto* identNode = new ASTNode{NodeType::Identifier};
+        NodePtr identNode(new ASTNode{NodeType::Identifier});
         identNode->token = tokens[pos].text;
         pos++;
+        span(identNode.get(), pos - 1);
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::LP) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         pos++;
-        ASTNode* paramListNode = parseParamList();
+        NodePtr paramListNode(parseParamList());
         // 无参数时插入空ParamList节点
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::RP) {
-            if (!paramListNode) paramListNode = new ASTNode{NodeType::ParamList};
+            if (!paramListNode) paramListNode.reset(span(new ASTNode{NodeType::ParamList}, pos));
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         pos++;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         pos++;
-        auto* node = new ASTNode{NodeType::FunctionDecl};
-        node->children.push_back(typeNode);
-        node->children.push_back(identNode);
-        if (paramListNode) node->children.push_back(paramListNode);
+        auto* node = span(new ASTNode{NodeType::FunctionDecl}, backup);
+        node->children.push_back(typeNode.release());
+        node->children.push_back(identNode.release());
+        if (paramListNode) node->children.push_back(paramListNode.release());
         debugLog("parseFunctionDecl_exit", pos);
         return node;
     }
@@ -49,44 +51,55 @@ namespace parser {
     // 函数定义：type_spec IDENT LP param_list RP compound_stmt
     ASTNode *Parser::parseFunctionDef() {
         debugLog("parseFunctionDef", pos);
+        RuleScope scope(profile, GrammarRule::FunctionDef, pos);
         int backup = pos;
-        ASTNode* typeNode = parseTypeSpec();
+        NodePtr typeNode(parseTypeSpec());
         if (!typeNode) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::IDENT) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
-        auto* identNode = new ASTNode{NodeType::Identifier};
+        NodePtr identNode(new ASTNode{NodeType::Identifier});
         identNode->token = tokens[pos].text;
         pos++;
+        span(identNode.get(), pos - 1);
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::LP) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         pos++;
-        ASTNode* paramListNode = parseParamList();
+        NodePtr paramListNode(parseParamList());
         // 无参数时插入空ParamList节点
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::RP) {
-            if (!paramListNode) paramListNode = new ASTNode{NodeType::ParamList};
+            if (!paramListNode) paramListNode.reset(span(new ASTNode{NodeType::ParamList}, pos));
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         pos++;
-        ASTNode* compoundNode = parseCompoundStmt();
+        NodePtr compoundNode;
+        int close = lazyBodies ? matchBrace(pos) : -1;
+        if (close >= 0) {
+            // 延迟解析：整个函数体只记录区间
+            int open = pos;
+            pos = close + 1;
+            compoundNode.reset(span(new ASTNode{NodeType::LazyBody}, open));
+        } else {
+            compoundNode.reset(parseCompoundStmt());
+        }
         if (!compoundNode) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
-        auto* node = new ASTNode{NodeType::FunctionDef};
-        node->children.push_back(typeNode);
-        node->children.push_back(identNode);
-        if (paramListNode) node->children.push_back(paramListNode);
-        node->children.push_back(compoundNode);
+        auto* node = span(new ASTNode{NodeType::FunctionDef}, backup);
+        node->children.push_back(typeNode.release());
+        node->children.push_back(identNode.release());
+        if (paramListNode) node->children.push_back(paramListNode.release());
+        node->children.push_back(compoundNode.release());
         debugLog("parseFunctionDef_exit", pos);
         return node;
     }
@@ -94,19 +107,20 @@ namespace parser {
     // 参数列表：param param_list_tail | ε
     ASTNode *Parser::parseParamList() {
         debugLog("parseParamList", pos);
+        RuleScope scope(profile, GrammarRule::ParamList, pos);
         // 如果参数列表为空，直接返回nullptr
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::RP) {
             return nullptr;
         }
         int backup = pos;
-        ASTNode* paramNode = parseParam();
+        NodePtr paramNode(parseParam());
         if (!paramNode) {
             return nullptr; // ε
         }
-        ASTNode* tailNode = parseParamListTail();
-        auto* node = new ASTNode{NodeType::ParamList};
-        node->children.push_back(paramNode);
-        if (tailNode) node->children.push_back(tailNode);
+        NodePtr tailNode(parseParamListTail());
+        auto* node = span(new ASTNode{NodeType::ParamList}, backup);
+        node->children.push_back(paramNode.release());
+        if (tailNode) node->children.push_back(tailNode.release());
         debugLog("parseParamList_exit", pos);
         return node;
     }
@@ -114,16 +128,18 @@ namespace parser {
     // 参数列表后续：COMMA param param_list_tail | ε
     ASTNode *Parser::parseParamListTail() {
         debugLog("parseParamListTail", pos);
+        RuleScope scope(profile, GrammarRule::ParamListTail, pos);
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::COMMA) {
+            int start = pos;
             pos++;
-            ASTNode* paramNode = parseParam();
+            NodePtr paramNode(parseParam());
             if (!paramNode) {
                 return nullptr;
             }
-            ASTNode* tailNode = parseParamListTail();
-            auto* node = new ASTNode{NodeType::ParamList};
-            node->children.push_back(paramNode);
-            if (tailNode) node->children.push_back(tailNode);
+            NodePtr tailNode(parseParamListTail());
+            auto* node = span(new ASTNode{NodeType::ParamList}, start);
+            node->children.push_back(paramNode.release());
+            if (tailNode) node->children.push_back(tailNode.release());
             debugLog("parseParamListTail_exit", pos);
             return node;
         }
@@ -133,23 +149,26 @@ namespace parser {
     // 单个参数：type_spec IDENT [LB [INT_CONST/IDENT] RB ...]
     ASTNode *Parser::parseParam() {
         debugLog("parseParam", pos);
+        RuleScope scope(profile, GrammarRule::Param, pos);
         int backup = pos;
-        ASTNode* typeNode = parseTypeSpec();
+        NodePtr typeNode(parseTypeSpec());
         if (!typeNode) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::IDENT) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
-        auto* identNode = new ASTNode{NodeType::Identifier};
+        NodePtr identNode(new ASTNode{NodeType::Identifier});
         identNode->token = tokens[pos].text;
         pos++;
+        span(identNode.get(), pos - 1);
         // 数组类型参数，允许无维度
-        ASTNode* arrayTypeNode = nullptr;
+        NodePtr arrayTypeNode;
+        int arrayStart = pos;
         while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LB) {
-            if (!arrayTypeNode) arrayTypeNode = new ASTNode{NodeType::ArrayType};
+            if (!arrayTypeNode) arrayTypeNode.reset(new ASTNode{NodeType::ArrayType});
             pos++;
             // 支持无维度（即直接遇到 RB）
             if (pos < tokens.size() && (tokens[pos].kind == lexer::TokenKind::INT_CONST || tokens[pos].kind == lexer::TokenKind::IDENT)) {
@@ -157,19 +176,20 @@ namespace parser {
                 dimNode->token = tokens[pos].text;
                 arrayTypeNode->children.push_back(dimNode);
                 pos++;
+                span(dimNode, pos - 1);
             }
             // 必须有右括号
             if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RB) {
-                delete arrayTypeNode;
-                pos = backup;
+                rewind(backup);
                 return nullptr;
             }
             pos++;
         }
-        auto* node = new ASTNode{NodeType::Param};
-        node->children.push_back(typeNode);
-        node->children.push_back(identNode);
-        if (arrayTypeNode) node->children.push_back(arrayTypeNode);
+        if (arrayTypeNode) span(arrayTypeNode.get(), arrayStart);
+        auto* node = span(new ASTNode{NodeType::Param}, backup);
+        node->children.push_back(typeNode.release());
+        node->children.push_back(identNode.release());
+        if (arrayTypeNode) node->children.push_back(arrayTypeNode.release());
         debugLog("parseParam_exit", pos);
         return node;
     }
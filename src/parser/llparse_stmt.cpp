@@ -5,35 +5,41 @@ namespace parser {
     // 复合语句：{ 局部变量定义; 语句列表 }
     ASTNode* Parser::parseCompoundStmt() {
         debugLog("parseCompoundStmt", pos);
+        RuleScope scope(profile, GrammarRule::CompoundStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::LC) {
             return nullptr;
         }
         pos++;
         // 局部变量定义部分
-        auto* varDeclList = new ASTNode{NodeType::VarDeclList};
+        NodePtr varDeclList(new ASTNode{NodeType::VarDeclList});
+        int varStart = pos;
         while (true) {
             int varBackup = pos;
-            ASTNode* varDecl = parseLocalVarDecl();
+            ASTNode* varDecl = nullptr;
+            try {
+                varDecl = parseLocalVarDecl();
+            } catch (const ParseError&) {
+                // 出错的定义丢弃，同步后继续
+                synchronize(varBackup, false);
+                if (pos > varBackup) continue;
+            }
             if (!varDecl) {
-                pos = varBackup;
+                rewind(varBackup);
                 break;
             }
             varDeclList->children.push_back(varDecl);
         }
+        span(varDeclList.get(), varStart);
         // 语句列表部分
-        ASTNode* stmtListNode = parseStmtList();
+        NodePtr stmtListNode(parseStmtList());
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RC) {
             error("compound_stmt: expected '}' at end of block");
-            pos = backup;
-            delete varDeclList;
-            if (stmtListNode) delete stmtListNode;
-            return nullptr;
         }
         pos++;
-        auto* node = new ASTNode{NodeType::CompoundStmt};
-        node->children.push_back(varDeclList); // 局部变量定义
-        if (stmtListNode) node->children.push_back(stmtListNode); // 语句列表
+        auto* node = span(new ASTNode{NodeType::CompoundStmt}, backup);
+        node->children.push_back(varDeclList.release()); // 局部变量定义
+        if (stmtListNode) node->children.push_back(stmtListNode.release()); // 语句列表
         debugLog("parseCompoundStmt_exit", pos);
         return node;
     }
@@ -41,12 +47,21 @@ namespace parser {
     // 语句列表：stmt stmt_list | ε
     ASTNode* Parser::parseStmtList() {
         debugLog("parseStmtList", pos);
+        RuleScope scope(profile, GrammarRule::StmtList, pos);
+        int start = pos;
         auto* node = new ASTNode{NodeType::StmtList};
         while (true) {
             int backup = pos;
-            ASTNode* stmtNode = parseStmt();
+            ASTNode* stmtNode = nullptr;
+            try {
+                stmtNode = parseStmt();
+            } catch (const ParseError&) {
+                // 出错的语句丢弃，同步后继续
+                synchronize(backup, false);
+                if (pos > backup) continue;
+            }
             if (!stmtNode) {
-                pos = backup;
+                rewind(backup);
                 break;
             }
             node->children.push_back(stmtNode);
@@ -56,6 +71,6 @@ namespace parser {
             delete node;
             return nullptr;
         }
-        return node;
+        return span(node, start);
     }
 }
@@ -5,35 +5,36 @@ namespace parser {
     // 语句分派
     ASTNode* Parser::parseStmt() {
         debugLog("parseStmt", pos);
+        RuleScope scope(profile, GrammarRule::Stmt, pos);
         int backup = pos;
         ASTNode* node = nullptr;
         node = parseIfStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseWhileStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseForStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseReturnStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseBreakStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseContinueStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseCompoundStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseVarDecl();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         node = parseExprStmt();
         if (node) { debugLog("parseStmt_exit", pos); return node; }
-        pos = backup;
+        rewind(backup);
         // 注释语句
         if (pos < tokens.size() &&
             (tokens[pos].kind == lexer::TokenKind::LINE_COMMENT || tokens[pos].kind == lexer::TokenKind::BLOCK_COMMENT)) {
@@ -42,7 +43,7 @@ namespace parser {
             node->token = tokens[pos].text;
             pos++;
             debugLog("parseStmt_exit", pos);
-            return node;
+            return span(node, pos - 1);
         }
         debugLog("parseStmt_exit", pos);
         return nullptr;
@@ -51,28 +52,26 @@ namespace parser {
     // 表达式语句：expr SEMI | SEMI
     ASTNode* Parser::parseExprStmt() {
         debugLog("parseExprStmt", pos);
+        RuleScope scope(profile, GrammarRule::ExprStmt, pos);
         int backup = pos;
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::SEMI) {
             pos++;
-            auto* node = new ASTNode{NodeType::ExprStmt};
+            auto* node = span(new ASTNode{NodeType::ExprStmt}, backup);
             debugLog("parseExprStmt_exit", pos);
             return node;
         }
-        ASTNode* exprNode = parseExpr();
+        NodePtr exprNode(parseExpr());
         if (!exprNode) {
-            pos = backup;
+            rewind(backup);
             debugLog("parseExprStmt_exit", pos);
             return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
             error("expr_stmt: expected ';' after expression");
-            pos = backup;
-            debugLog("parseExprStmt_exit", pos);
-            return nullptr;
         }
         pos++;
-        auto* node = new ASTNode{NodeType::ExprStmt};
-        node->children.push_back(exprNode);
+        auto* node = span(new ASTNode{NodeType::ExprStmt}, backup);
+        node->children.push_back(exprNode.release());
         debugLog("parseExprStmt_exit", pos);
         return node;
     }
@@ -80,6 +79,7 @@ namespace parser {
     // if语句
     ASTNode* Parser::parseIfStmt() {
         debugLog("parseIfStmt", pos);
+        RuleScope scope(profile, GrammarRule::IfStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::IF) {
             return nullptr;
@@ -87,45 +87,35 @@ namespace parser {
         pos++;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::LP) {
             error("if_stmt: expected '(' after 'if'");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        ASTNode* cond = parseExpr();
+        NodePtr cond(parseExpr());
         if (!cond) {
             error("if_stmt: expected condition expression");
-            pos = backup;
-            return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
             error("if_stmt: expected ')' after condition");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        ASTNode* thenStmt = parseStmt();
+        NodePtr thenStmt(parseStmt());
         if (!thenStmt) {
             error("if_stmt: expected statement after condition");
-            pos = backup;
-            return nullptr;
         }
         ASTNode* node = nullptr;
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::ELSE) {
             pos++;
-            ASTNode* elseStmt = parseStmt();
+            NodePtr elseStmt(parseStmt());
             if (!elseStmt) {
                 error("if_stmt: expected statement after 'else'");
-                pos = backup;
-                return nullptr;
             }
-            node = new ASTNode{NodeType::IfStmt};
-            node->children.push_back(cond);
-            node->children.push_back(thenStmt);
-            node->children.push_back(elseStmt);
+            node = span(new ASTNode{NodeType::IfStmt}, backup);
+            node->children.push_back(cond.release());
+            node->children.push_back(thenStmt.release());
+            node->children.push_back(elseStmt.release());
         } else {
-            node = new ASTNode{NodeType::IfStmt};
-            node->children.push_back(cond);
-            node->children.push_back(thenStmt);
+            node = span(new ASTNode{NodeType::IfStmt}, backup);
+            node->children.push_back(cond.release());
+            node->children.push_back(thenStmt.release());
         }
         debugLog("parseIfStmt_exit", pos);
         return node;
@@ -134,6 +124,7 @@ namespace parser {
     // while语句
     ASTNode* Parser::parseWhileStmt() {
         debugLog("parseWhileStmt", pos);
+        RuleScope scope(profile, GrammarRule::WhileStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::WHILE) {
             return nullptr;
@@ -141,31 +132,23 @@ namespace parser {
         pos++;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::LP) {
             error("while_stmt: expected '(' after 'while'");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        ASTNode* cond = parseExpr();
+        NodePtr cond(parseExpr());
         if (!cond) {
             error("while_stmt: expected condition expression");
-            pos = backup;
-            return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
             error("while_stmt: expected ')' after condition");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        ASTNode* body = parseStmt();
+        NodePtr body(parseStmt());
         if (!body) {
             error("while_stmt: expected statement after condition");
-            pos = backup;
-            return nullptr;
         }
-        auto* node = new ASTNode{NodeType::WhileStmt};
-        node->children.push_back(cond);
-        node->children.push_back(body);
+        auto* node = span(new ASTNode{NodeType::WhileStmt}, backup);
+        node->children.push_back(cond.release());
+        node->children.push_back(body.release());
         debugLog("parseWhileStmt_exit", pos);
         return node;
     }
@@ -173,6 +156,7 @@ namespace parser {
     // for语句
     ASTNode* Parser::parseForStmt() {
         debugLog("parseForStmt", pos);
+        RuleScope scope(profile, GrammarRule::ForStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::FOR) {
             return nullptr;
@@ -180,45 +164,33 @@ namespace parser {
         pos++;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::LP) {
             error("for_stmt: expected '(' after 'for'");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        ASTNode* init = parseExprStmt();
+        NodePtr init(parseExprStmt());
         if (!init) {
             error("for_stmt: expected init expr_stmt");
-            pos = backup;
-            return nullptr;
         }
-        ASTNode* cond = parseExprStmt();
+        NodePtr cond(parseExprStmt());
         if (!cond) {
             error("for_stmt: expected condition expr_stmt");
-            pos = backup;
-            return nullptr;
         }
-        ASTNode* step = parseExpr();
+        NodePtr step(parseExpr());
         if (!step) {
             error("for_stmt: expected step expression");
-            pos = backup;
-            return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RP) {
             error("for_stmt: expected ')' after for header");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        ASTNode* body = parseStmt();
+        NodePtr body(parseStmt());
         if (!body) {
             error("for_stmt: expected statement after for header");
-            pos = backup;
-            return nullptr;
         }
-        auto* node = new ASTNode{NodeType::ForStmt};
-        node->children.push_back(init);
-        node->children.push_back(cond);
-        node->children.push_back(step);
-        node->children.push_back(body);
+        auto* node = span(new ASTNode{NodeType::ForStmt}, backup);
+        node->children.push_back(init.release());
+        node->children.push_back(cond.release());
+        node->children.push_back(step.release());
+        node->children.push_back(body.release());
         debugLog("parseForStmt_exit", pos);
         return node;
     }
@@ -226,6 +198,7 @@ namespace parser {
     // return语句
     ASTNode* Parser::parseReturnStmt() {
         debugLog("parseReturnStmt", pos);
+        RuleScope scope(profile, GrammarRule::ReturnStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RETURN) {
             return nullptr;
@@ -233,24 +206,20 @@ namespace parser {
         pos++;
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::SEMI) {
             pos++;
-            auto* node = new ASTNode{NodeType::ReturnStmt};
+            auto* node = span(new ASTNode{NodeType::ReturnStmt}, backup);
             debugLog("parseReturnStmt_exit", pos);
             return node;
         }
-        ASTNode* exprNode = parseExpr();
+        NodePtr exprNode(parseExpr());
         if (!exprNode) {
             error("return_stmt: expected expression after 'return'");
-            pos = backup;
-            return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
             error("return_stmt: expected ';' after return expression");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        auto* node = new ASTNode{NodeType::ReturnStmt};
-        node->children.push_back(exprNode);
+        auto* node = span(new ASTNode{NodeType::ReturnStmt}, backup);
+        node->children.push_back(exprNode.release());
         debugLog("parseReturnStmt_exit", pos);
         return node;
     }
@@ -258,6 +227,7 @@ namespace parser {
     // break语句
     ASTNode* Parser::parseBreakStmt() {
         debugLog("parseBreakStmt", pos);
+        RuleScope scope(profile, GrammarRule::BreakStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::BREAK) {
             return nullptr;
@@ -265,11 +235,9 @@ namespace parser {
         pos++;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
             error("break_stmt: expected ';' after 'break'");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        auto* node = new ASTNode{NodeType::BreakStmt};
+        auto* node = span(new ASTNode{NodeType::BreakStmt}, backup);
         debugLog("parseBreakStmt_exit", pos);
         return node;
     }
@@ -277,6 +245,7 @@ namespace parser {
     // continue语句
     ASTNode* Parser::parseContinueStmt() {
         debugLog("parseContinueStmt", pos);
+        RuleScope scope(profile, GrammarRule::ContinueStmt, pos);
         int backup = pos;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::CONTINUE) {
             return nullptr;
@@ -284,11 +253,9 @@ namespace parser {
         pos++;
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
             error("continue_stmt: expected ';' after 'continue'");
-            pos = backup;
-            return nullptr;
         }
         pos++;
-        auto* node = new ASTNode{NodeType::ContinueStmt};
+        auto* node = span(new ASTNode{NodeType::ContinueStmt}, backup);
         debugLog("parseContinueStmt_exit", pos);
         return node;
     }
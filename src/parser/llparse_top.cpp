@@ -11,30 +11,29 @@ namespace parser {
     // 解析程序
     ASTNode *Parser::parseProgram() {
         debugLog("parseProgram", pos);
+        RuleScope scope(profile, GrammarRule::Program, pos);
         ASTNode* declList = parseExternalDeclList();
         debugLog("parseProgram_exit", pos);
         if (!declList) {
-            error("program: expected at least one external declaration");
-            return nullptr;
+            // 全部声明都出错时仍返回空的声明列表，保证AST结构完整
+            if (diagnostics.empty()) report("program: expected at least one external declaration");
+            declList = span(new ASTNode{NodeType::ExternalDeclList}, 0);
         }
         auto* node = new ASTNode{NodeType::Program};
         node->children.push_back(declList);
-        root = node;
+        root = span(node, 0);
         return root;
     }
 
     // 解析外部声明列表
     ASTNode *Parser::parseExternalDeclList() {
         debugLog("parseExternalDeclList", pos);
+        RuleScope scope(profile, GrammarRule::ExternalDeclList, pos);
+        int start = pos;
         auto* node = new ASTNode{NodeType::ExternalDeclList};
-        while (true) {
-            int backup = pos;
-            ASTNode* decl = parseExternalDecl();
-            if (!decl) {
-                pos = backup;
-                break;
-            }
-            node->children.push_back(decl);
+        ASTNode* decl = nullptr;
+        while (nextExternalDecl(decl)) {
+            if (decl) node->children.push_back(decl);
         }
         debugLog("parseExternalDeclList_exit", pos);
         // 如果没有任何外部声明，允许为空（不报错）
@@ -42,12 +41,31 @@ namespace parser {
             delete node;
             return nullptr;
         }
-        return node;
+        return span(node, start);
+    }
+
+    // 解析下一个外部声明，出错时记录诊断并同步到下一个声明，此时decl为空
+    // 返回false表示已没有更多声明
+    bool Parser::nextExternalDecl(ASTNode*& decl) {
+        int backup = pos;
+        try {
+            decl = parseExternalDecl();
+        } catch (const ParseError&) {
+            decl = nullptr;
+            synchronize(backup, true);
+            return pos > backup;
+        }
+        if (!decl) {
+            rewind(backup);
+            return false;
+        }
+        return true;
     }
 
     // 解析外部声明
     ASTNode *Parser::parseExternalDecl() {
         debugLog("parseExternalDecl", pos);
+        RuleScope scope(profile, GrammarRule::ExternalDecl, pos);
         // 遇到EOF_TOKEN，说明文件结束
         if (pos >= tokens.size() || tokens[pos].kind == lexer::TokenKind::EOF_TOKEN) {
             return nullptr;
@@ -62,22 +80,21 @@ namespace parser {
             auto* node = new ASTNode{kind == lexer::TokenKind::LINE_COMMENT ? LineComment : BlockComment};
             node->token = tokens[pos].text;
             pos++;
-            return node;
+            return span(node, pos - 1);
         }
 
         node = parseFunctionDef();
         if (node) { debugLog("parseExternalDecl_funcdef", pos); return node; }
-        pos = backup;
+        rewind(backup);
 
         node = parseFunctionDecl();
         if (node) { debugLog("parseExternalDecl_funcdecl", pos); return node; }
-        pos = backup;
+        rewind(backup);
 
         node = parseVarDecl();
         if (node) { debugLog("parseExternalDecl_vardecl", pos); return node; }
-        pos = backup;
+        rewind(backup);
 
         error("external_decl: expected function_def/function_decl/var_decl");
-        return nullptr;
     }
 }
\ No newline at end of file
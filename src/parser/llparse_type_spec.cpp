@@ -4,9 +4,9 @@
 namespace parser {
     ASTNode *Parser::parseTypeSpec() {
         debugLog("parseTypeSpec", pos);
+        RuleScope scope(profile, GrammarRule::TypeSpec, pos);
         if (pos >= tokens.size()) {
             error("type_spec: unexpected end of input, expected type keyword (int/float/char/void)");
-            return nullptr;
         }
         auto kind = tokens[pos].kind;
         if (lexer::isTypeSpecifier(kind)) {
@@ -14,10 +14,9 @@ namespace parser {
             node->token = tokens[pos].text;
             pos++;
             debugLog("parseTypeSpec_exit", pos);
-            return node;
+            return span(node, pos - 1);
         } else {
             error("type_spec: expected type keyword (int/float/char/void)");
-            return nullptr;
         }
     }
 }
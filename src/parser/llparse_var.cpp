@@ -8,32 +8,31 @@ namespace parser {
      */
     ASTNode *Parser::parseVarDecl() {
         debugLog("parseVarDecl", pos);
+        RuleScope scope(profile, GrammarRule::VarDecl, pos);
         // 只有类型关键字才尝试变量声明，否则直接返回nullptr
         if (pos >= tokens.size() ||
             !lexer::isTypeSpecifier(tokens[pos].kind)) {
             return nullptr;
         }
         int backup = pos;
-        ASTNode* typeNode = parseTypeSpec();
+        NodePtr typeNode(parseTypeSpec());
         if (!typeNode) {
             error("var_decl: expected type_spec (int/float/char/void)");
-            pos = backup;
-            return nullptr;
         }
         // 检查标识符
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::IDENT) {
             error("var_decl: expected identifier after type_spec");
-            pos = backup;
-            return nullptr;
         }
         // 标识符节点
-        auto* identNode = new ASTNode{NodeType::Identifier};
+        NodePtr identNode(new ASTNode{NodeType::Identifier});
         identNode->token = tokens[pos].text;
         pos++;
+        span(identNode.get(), pos - 1);
         // 检查是否为数组声明
-        ASTNode* arrayTypeNode = nullptr;
+        NodePtr arrayTypeNode;
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LB) {
-            arrayTypeNode = new ASTNode{NodeType::ArrayType};
+            arrayTypeNode.reset(new ASTNode{NodeType::ArrayType});
+            int arrayStart = pos;
             while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LB) {
                 pos++;
                 if (pos < tokens.size() && (tokens[pos].kind == lexer::TokenKind::INT_CONST || tokens[pos].kind == lexer::TokenKind::IDENT)) {
@@ -41,47 +40,37 @@ namespace parser {
                     dimNode->token = tokens[pos].text;
                     arrayTypeNode->children.push_back(dimNode);
                     pos++;
+                    span(dimNode, pos - 1);
                 } else {
                     error("array_decl: expected dimension inside []");
-                    delete arrayTypeNode;
-                    pos = backup;
-                    return nullptr;
                 }
                 if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RB) {
                     error("array_decl: expected ']' after dimension");
-                    delete arrayTypeNode;
-                    pos = backup;
-                    return nullptr;
                 }
                 pos++;
             }
+            span(arrayTypeNode.get(), arrayStart);
         }
-        auto* varNode = new ASTNode{NodeType::VarDecl};
-        varNode->children.push_back(typeNode);
-        varNode->children.push_back(identNode);
-        if (arrayTypeNode) varNode->children.push_back(arrayTypeNode);
+        NodePtr varNode(new ASTNode{NodeType::VarDecl});
+        varNode->children.push_back(typeNode.release());
+        varNode->children.push_back(identNode.release());
+        if (arrayTypeNode) varNode->children.push_back(arrayTypeNode.release());
         // 检查是否有赋值
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::ASSIGN) {
             pos++;
             ASTNode* exprNode = parseExpr();
             if (!exprNode) {
                 error("var_decl: expected expression after '='");
-                delete varNode;
-                pos = backup;
-                return nullptr;
             }
             varNode->children.push_back(exprNode);
         }
         // 必须以分号结尾
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
             error("var_decl: expected ';' at end of declaration");
-            delete varNode;
-            pos = backup;
-            return nullptr;
         }
         pos++;
         debugLog("parseVarDecl_exit", pos);
-        return varNode;
+        return span(varNode.release(), backup);
     }
 
     // 局部变量声明
@@ -90,27 +79,30 @@ namespace parser {
      */
     ASTNode *Parser::parseLocalVarDecl() {
         debugLog("parseLocalVarDecl", pos);
+        RuleScope scope(profile, GrammarRule::LocalVarDecl, pos);
         if (pos >= tokens.size() ||
             !lexer::isTypeSpecifier(tokens[pos].kind)) {
             return nullptr;
         }
         int backup = pos;
-        ASTNode* typeNode = parseTypeSpec();
+        NodePtr typeNode(parseTypeSpec());
         if (!typeNode) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::IDENT) {
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
-        auto* identNode = new ASTNode{NodeType::Identifier};
+        NodePtr identNode(new ASTNode{NodeType::Identifier});
         identNode->token = tokens[pos].text;
         pos++;
+        span(identNode.get(), pos - 1);
         // 检查是否为数组声明
-        ASTNode* arrayTypeNode = nullptr;
+        NodePtr arrayTypeNode;
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LB) {
-            arrayTypeNode = new ASTNode{NodeType::ArrayType};
+            arrayTypeNode.reset(new ASTNode{NodeType::ArrayType});
+            int arrayStart = pos;
             while (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::LB) {
                 pos++;
                 if (pos < tokens.size() && (tokens[pos].kind == lexer::TokenKind::INT_CONST || tokens[pos].kind == lexer::TokenKind::IDENT)) {
@@ -118,40 +110,38 @@ namespace parser {
                     dimNode->token = tokens[pos].text;
                     arrayTypeNode->children.push_back(dimNode);
                     pos++;
+                    span(dimNode, pos - 1);
                 } else {
-                    delete arrayTypeNode;
-                    pos = backup;
+                    rewind(backup);
                     return nullptr;
                 }
                 if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::RB) {
-                    delete arrayTypeNode;
-                    pos = backup;
+                    rewind(backup);
                     return nullptr;
                 }
                 pos++;
             }
+            span(arrayTypeNode.get(), arrayStart);
         }
-        auto* varNode = new ASTNode{NodeType::LocalVarDecl};
-        varNode->children.push_back(typeNode);
-        varNode->children.push_back(identNode);
-        if (arrayTypeNode) varNode->children.push_back(arrayTypeNode);
+        NodePtr varNode(new ASTNode{NodeType::LocalVarDecl});
+        varNode->children.push_back(typeNode.release());
+        varNode->children.push_back(identNode.release());
+        if (arrayTypeNode) varNode->children.push_back(arrayTypeNode.release());
         if (pos < tokens.size() && tokens[pos].kind == lexer::TokenKind::ASSIGN) {
             pos++;
             ASTNode* exprNode = parseExpr();
             if (!exprNode) {
-                delete varNode;
-                pos = backup;
+                rewind(backup);
                 return nullptr;
             }
             varNode->children.push_back(exprNode);
         }
         if (pos >= tokens.size() || tokens[pos].kind != lexer::TokenKind::SEMI) {
-            delete varNode;
-            pos = backup;
+            rewind(backup);
             return nullptr;
         }
         pos++;
         debugLog("parseLocalVarDecl_exit", pos);
-        return varNode;
+        return span(varNode.release(), backup);
     }
 }
@@ -0,0 +1,126 @@
+#include "ast.h"
+#include "parser.h"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace parser {
+    bool TopLevelSplitter::feed(lexer::TokenKind kind) {
+        bool end = false;
+        if (depth == 0 && atStart &&
+            (kind == lexer::TokenKind::LINE_COMMENT || kind == lexer::TokenKind::BLOCK_COMMENT)) {
+            end = true;
+        } else if (kind == lexer::TokenKind::LC) {
+            depth++;
+        } else if (kind == lexer::TokenKind::RC) {
+            if (depth > 0) depth--;
+            end = depth == 0;
+        } else if (kind == lexer::TokenKind::SEMI && depth == 0) {
+            end = true;
+        }
+        atStart = end;
+        return end;
+    }
+
+    // 按顶层声明边界切分Token序列，返回每段的[起始, 结束)下标
+    std::vector<std::pair<int, int>> Parser::splitTopLevel() const {
+        std::vector<std::pair<int, int>> ranges;
+        TopLevelSplitter splitter;
+        int start = 0;
+        int i = 0;
+        for (; i < (int)tokens.size(); ++i) {
+            auto kind = tokens[i].kind;
+            if (kind == lexer::TokenKind::EOF_TOKEN) break;
+            if (splitter.feed(kind)) {
+                ranges.emplace_back(start, i + 1);
+                start = i + 1;
+            }
+        }
+        // 末尾不完整的声明也单独成段，交给子解析器报错
+        if (start < i) ranges.emplace_back(start, i);
+        return ranges;
+    }
+
+    // 用独立的子解析器解析[begin, end)区间内的顶层声明
+    // 调用方需保证不同线程处理的区间互不相交：Token先移入子解析器，解析完再移回
+    // 区间内的语法错误追加到diags
+    std::vector<ASTNode*> Parser::parseRange(int begin, int end, std::vector<Diagnostic>& diags) {
+        std::vector<ASTNode*> decls;
+        if (begin >= end) return decls;
+        std::vector<lexer::Token> slice(std::make_move_iterator(tokens.begin() + begin),
+                                        std::make_move_iterator(tokens.begin() + end));
+        const auto& last = slice.back();
+        slice.push_back(lexer::Token{lexer::TokenKind::EOF_TOKEN, "", last.line, last.column});
+        Parser sub(std::move(slice), debug);
+        sub.tokenBase = tokenBase + begin;
+        sub.lazyBodies = lazyBodies;
+        sub.flatChains = flatChains;
+        // 子解析器的节点池在其析构前由本解析器接管
+        if (exprPool) sub.exprPool.reset(new ExprPool);
+        // 子解析器先记在自己的统计里，结束后合并，避免多线程同时写同一份计数
+        GrammarProfile subProfile;
+        if (profile) sub.profile = &subProfile;
+        ASTNode* decl = nullptr;
+        // 区间末尾是补上的EOF，读到它就停，不再多探测一次，剖析中的调用次数与串行解析一致
+        int sentinel = static_cast<int>(sub.tokens.size()) - 1;
+        while (sub.pos < sentinel && sub.nextExternalDecl(decl)) {
+            if (decl) decls.push_back(decl);
+        }
+        if (profile) profile->merge(subProfile);
+        if (exprPool) exprPool->adopt(*sub.exprPool);
+        for (auto& diag : sub.diagnostics) diags.push_back(std::move(diag));
+        std::move(sub.tokens.begin(), sub.tokens.end() - 1, tokens.begin() + begin);
+        return decls;
+    }
+
+    // 各段由独立的子解析器在工作线程上解析，第i段的结果和诊断放在results[i]和rangeDiags[i]
+    void Parser::parseRanges(const std::vector<std::pair<int, int>>& ranges,
+                             std::vector<std::vector<ASTNode*>>& results,
+                             std::vector<std::vector<Diagnostic>>& rangeDiags) {
+        results.assign(ranges.size(), {});
+        rangeDiags.assign(ranges.size(), {});
+        std::atomic<size_t> next(0);
+
+        auto worker = [&]() {
+            while (true) {
+                size_t idx = next.fetch_add(1);
+                if (idx >= ranges.size()) break;
+                results[idx] = parseRange(ranges[idx].first, ranges[idx].second, rangeDiags[idx]);
+            }
+        };
+
+        size_t workerCount = std::min<size_t>(jobs, ranges.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workerCount; ++i) threads.emplace_back(worker);
+        worker(); // 当前线程同样参与解析
+        for (auto& t : threads) t.join();
+    }
+
+    // 并行解析：各段的结果按源码顺序拼接
+    ASTNode *Parser::parseProgramParallel() {
+        debugLog("parseProgramParallel", pos);
+        auto ranges = splitTopLevel();
+        std::vector<std::vector<ASTNode*>> results;
+        std::vector<std::vector<Diagnostic>> rangeDiags;
+        parseRanges(ranges, results, rangeDiags);
+        // 各区间的诊断按源码顺序拼接
+        for (auto& diags : rangeDiags) {
+            for (auto& diag : diags) diagnostics.push_back(std::move(diag));
+        }
+
+        pos = ranges.empty() ? pos : ranges.back().second;
+        auto* declList = span(new ASTNode{NodeType::ExternalDeclList}, 0);
+        for (auto& decls : results) {
+            for (auto* decl : decls) declList->children.push_back(decl);
+        }
+        debugLog("parseProgramParallel_exit", pos);
+        if (declList->children.empty() && diagnostics.empty()) {
+            report("program: expected at least one external declaration");
+        }
+        auto* node = span(new ASTNode{NodeType::Program}, 0);
+        node->children.push_back(declList);
+        return node;
+    }
+}
@@ -2,6 +2,7 @@
 #include "lexer.h"
 #include "ast.h"
 #include "token_translater.h"
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <fstream>
@@ -15,32 +16,111 @@ namespace parser {
         }
     }
     Parser::Parser(lexer::Lexer &lexer, const bool debug,std::string output):
-        debug(debug),output(std::move(output)), lexer(lexer), root(nullptr), tokens(lexer.tokenize()),pos(0) {}
+        debug(debug),output(std::move(output)), root(nullptr), tokens(lexer.tokenize()),pos(0) {}
+    Parser::Parser(std::vector<lexer::Token> tokens, const bool debug):
+        debug(debug),output("ast.txt"), root(nullptr), tokens(std::move(tokens)),pos(0) {}
+    Parser::Parser(NodeArena nodes, const bool debug):
+        debug(debug),output("ast.txt"), root(nodes.get()), pos(0), arena(std::move(nodes)) {}
+    // lexer随成员自动析构；表达式池和节点块在root之后释放
     Parser::~Parser() {
-        lexer.~Lexer();
-        if (root) root->~ASTNode();
+        if (root && !root->shared) delete root;
     }
     ASTNode *Parser::parse() {
         if (root) return root;
-        root = parseProgram();
+        if (hashCons && !exprPool) exprPool.reset(new ExprPool);
+        root = jobs > 1 ? parseProgramParallel() : parseProgram();
+        printDiagnostics();
+        if (debug && exprPool) {
+            std::cout << "[DEBUG] hash-consing: " << exprPool->size() << " shared expression nodes, "
+                      << exprPool->reused() << " duplicates merged" << std::endl;
+        }
         return root;
     }
 
-    // 报错
-    void Parser::error(const std::string& msg) const {
-        fprintf(stderr, "Parse error: %s\n", msg.c_str());
-        // 打印当前 token 及上下文
-        int ctx_start = std::max(0, pos - 2);
-        int ctx_end = std::min((int)tokens.size() - 1, pos + 2);
-        fprintf(stderr, "Context tokens (pos=%d):\n", pos);
-        for (int i = ctx_start; i <= ctx_end; ++i) {
-            const auto& tk = tokens[i];
-            fprintf(stderr, "  [%s] '%s' (line %d, col %d)%s\n",
-                lexer::TokenKindToString(tk.kind).c_str(), tk.text.c_str(), tk.line, tk.column,
-                (i == pos ? " <-- current" : "")
-            );
+    size_t Parser::textSize() const {
+        size_t n = 0;
+        for (const auto& tk : tokens) n += tk.text.size();
+        return n;
+    }
+
+    // 记录语法错误，位置取当前Token
+    void Parser::report(const std::string& msg) {
+        int at = std::min(pos, std::max(0, (int)tokens.size() - 1));
+        Diagnostic diag{tokenBase + at, msg};
+        // 诊断大多按位置递增产生，只有回溯后才需要往前插
+        auto it = diagnostics.end();
+        while (it != diagnostics.begin() && (it - 1)->token > diag.token) --it;
+        diagnostics.insert(it, std::move(diag));
+    }
+
+    // 报错：记录诊断后抛出，由最近的语句列表或顶层声明列表恢复
+    void Parser::error(const std::string& msg) {
+        report(msg);
+        throw ParseError{};
+    }
+
+    // 恐慌模式恢复：从出错位置向后跳过Token，start为出错的语句或声明的起点，用来确定括号深度
+    // - 深度0的 ';' 或使深度回到0的 '}'：跳过它后停下
+    // - 语句级遇到多出来的 '}'：停在它前面，留给外层复合语句
+    // - 顶层遇到深度0的类型说明符：停在它前面，作为下一个声明的开头
+    void Parser::synchronize(int start, bool topLevel) {
+        int errorPos = pos;
+        int depth = 0;
+        for (int i = start; i < (int)tokens.size(); ++i) {
+            auto kind = tokens[i].kind;
+            if (kind == lexer::TokenKind::EOF_TOKEN) {
+                pos = i;
+                return;
+            }
+            bool past = i >= errorPos;
+            if (kind == lexer::TokenKind::LC) {
+                depth++;
+            } else if (kind == lexer::TokenKind::RC) {
+                if (depth == 0) {
+                    // 多出来的 '}'
+                    if (past) {
+                        pos = topLevel ? i + 1 : i;
+                        return;
+                    }
+                } else if (--depth == 0 && past) {
+                    pos = i + 1;
+                    return;
+                }
+            } else if (depth == 0 && past) {
+                if (kind == lexer::TokenKind::SEMI) {
+                    pos = i + 1;
+                    return;
+                }
+                if (topLevel && i > start && lexer::isTypeSpecifier(kind)) {
+                    pos = i;
+                    return;
+                }
+            }
         }
-        exit(EXIT_FAILURE);
+        pos = (int)tokens.size();
     }
-}
 
+    // 按出错先后输出诊断
+    void Parser::printDiagnostics() const {
+        for (const auto& diag : diagnostics) {
+            int at = diag.token - tokenBase;
+            if (at >= 0 && at < (int)tokens.size()) {
+                const auto& tk = tokens[at];
+                fprintf(stderr, "Parse error at line %d, col %d: %s\n", tk.line, tk.column, diag.message.c_str());
+            } else {
+                fprintf(stderr, "Parse error: %s\n", diag.message.c_str());
+            }
+            // 打印出错 token 及上下文
+            int ctx_start = std::max(0, at - 2);
+            int ctx_end = std::min((int)tokens.size() - 1, at + 2);
+            fprintf(stderr, "Context tokens (pos=%d):\n", diag.token);
+            for (int i = ctx_start; i <= ctx_end; ++i) {
+                const auto& tk = tokens[i];
+                fprintf(stderr, "  [%s] '%s' (line %d, col %d)%s\n",
+                    lexer::TokenKindToString(tk.kind).c_str(), tk.text.c_str(), tk.line, tk.column,
+                    (i == at ? " <-- current" : "")
+                );
+            }
+        }
+    }
+}
@@ -1,20 +1,109 @@
 #ifndef PARSER_H
 #define PARSER_H
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include "lexer.h"
 #include "ast.h"
+#include "expr_pool.h"
+#include "grammar_profile.h"
 #include "token.h"
 #include "token_translater.h"
 
 namespace parser {
+    // 语法错误诊断
+    struct Diagnostic {
+        int token;           // 出错位置的Token下标（相对整个文件）
+        std::string message;
+    };
+
+    // 源码的一处编辑：把[offset, offset + removed)的字节替换为inserted
+    struct SourceEdit {
+        size_t offset;
+        size_t removed;
+        std::string inserted;
+        // 覆盖before到after全部改动的单处编辑：去掉两者的公共前缀和公共后缀，剩下的即为替换内容
+        static SourceEdit between(const std::string& before, const std::string& after);
+    };
+
+    // 顶层声明的切分规则：深度为0时遇到 ';' 或使深度回到0的 '}' 即结束一段，顶层注释单独成段
+    // 按顺序逐个喂入Token种类，feed返回真表示该Token是当前段的最后一个
+    class TopLevelSplitter {
+    public:
+        bool feed(lexer::TokenKind kind);
+    private:
+        int depth = 0;
+        bool atStart = true;
+    };
+
+    // 从lexer逐段读取顶层声明的Token（切分规则同TopLevelSplitter），只读不解析
+    class TopLevelReader {
+    public:
+        explicit TopLevelReader(lexer::Lexer& source) : source(source) {}
+        bool next(std::vector<lexer::Token>& chunk); // 读取下一段到chunk，已无Token时返回false
+        int chunkBegin() const { return begin; } // 最近一段第一个Token在整个文件中的下标
+        int consumed() const { return count; }   // 已读取的Token数
+    private:
+        lexer::Lexer& source;
+        TopLevelSplitter splitter;
+        bool done = false;
+        int begin = 0;
+        int count = 0;
+    };
+
     class Parser {
     public:
         explicit Parser(FILE *file, bool debug = false,std::string output="ast.txt");
-        explicit Parser(lexer::Lexer &lexer, bool debug = false,std::string output="ast.txt");
+        explicit Parser(lexer::Lexer &lexer, bool debug = false,std::string output="ast.txt"); // 只取Token，lexer仍归调用方
+        Parser(const Parser&) = delete;
+        Parser& operator=(const Parser&) = delete;
+        explicit Parser(std::vector<lexer::Token> tokens, bool debug = false);
+        explicit Parser(NodeArena nodes, bool debug = false); // 接管已有的AST（如从缓存加载），不再解析
         ~Parser();
         ASTNode* parse(); // 解析输入的Token序列，返回AST根节点
+        // 流式解析：从source逐个读取Token，每凑齐一个顶层声明就解析并依次交给sink，由sink取得所有权
+        // 不建立整棵AST，内存只与最大的单个顶层声明成正比；诊断照常收集，位置为整个文件的Token下标
+        // hashCons时声明中的共享节点归本解析器的表达式池，sink留下的声明只能在本解析器存续期间使用
+        void parseStream(lexer::Lexer& source, const std::function<void(ASTNode*)>& sink);
+        // 解析一段完整的顶层声明Token（如TopLevelReader读出的一段），base为其在整个文件中的起始下标
+        // 解析出的声明依次交给sink，返回声明个数
+        size_t parseChunk(std::vector<lexer::Token> chunk, int base, const std::function<void(ASTNode*)>& sink);
+        // 增量解析：对内存中的源码做词法分析，按顶层声明逐段解析（同并行模式），
+        // 并记下各段的Token区间、内容哈希和解析结果，之后可用reparse只重解析编辑涉及的声明。诊断不在此输出
+        ASTNode* parseSource(std::string text);
+        // 把edit应用到上次parseSource/reparse的源码上并增量重解析：只从编辑处所在的顶层声明起重新做词法分析，
+        // 与旧Token重新对齐后即停止；新的各段按内容哈希与被覆盖的旧段比对，相同的复用原子树，其余重新解析，
+        // 编辑之后的声明按指针复用，只平移其Token下标。返回根节点（仍是原来的节点），edit越界时返回nullptr且不做改动
+        ASTNode* reparse(const SourceEdit& edit);
+        // 最近一次reparse的工作量
+        struct ReparseStats {
+            size_t relexedBytes = 0;   // 重新做词法分析的字节数
+            size_t reparsedRanges = 0; // 重新解析的顶层声明段数
+            size_t reusedRanges = 0;   // 复用原子树的段数（含按内容哈希匹配上的）
+        };
+        ReparseStats lastReparse;
         void outputAST(std::string& filename);
+        bool exportAST(std::string& filename, const std::string& format); // 以json或sexpr格式流式导出完整AST
+        void outputSymbols(std::string& filename); // 列出顶层声明，不需要解析函数体
+        ASTNode* body(ASTNode* funcDef); // 取函数定义的函数体，未解析的在此时解析
+        void expandBodies(); // 解析所有尚未解析的函数体
+        size_t textSize() const; // 全部Token文本的字节数，用于估计输出大小
+        const std::vector<lexer::Token>& tokenList() const { return tokens; }
         bool debug = false;
+        unsigned jobs = 1; // 大于1时按顶层声明切分，多线程并行解析
+        GrammarProfile* profile = nullptr; // 非空时记录各文法规则的调用、回溯与耗时
+        // 为真时函数体按括号匹配跳过，只留LazyBody占位节点，首次访问时再解析；
+        // 不经过Parser访问AST的代码（如AST缓存）使用前需先调用expandBodies
+        bool lazyBodies = false;
+        // 为真时相同的表达式子树共享同一组节点（见ExprPool），共享节点的Token区间只对第一次出现处有效；
+        // jobs大于1时只在同一顶层声明段内共享，共享节点的区间不越出所属的段
+        bool hashCons = false;
+        // 为真时同一优先级的左结合运算链合为一个n元节点，长链的深度不再随长度增长
+        bool flatChains = false;
+        const ExprPool* expressionPool() const { return exprPool.get(); }
         std::string output;
+        std::vector<Diagnostic> diagnostics; // 收集到的语法错误，按出错位置排序；出错的声明或语句不进入AST
+        void printDiagnostics() const; // 按出错先后输出诊断及上下文Token
         lexer::Lexer lexer;
         void debugLog(const std::string& funcName, int pos) const {
             if (!debug) return;
@@ -29,13 +118,61 @@ namespace parser {
         ASTNode* root;
         std::vector<lexer::Token> tokens;
         int pos;
-        void error(const std::string& msg) const;
+        int tokenBase = 0; // 子解析器的Token下标相对整个文件的偏移
+        std::unique_ptr<ExprPool> exprPool; // 须在root之后释放
+        NodeArena arena; // 从缓存接管的AST，root指向其0号节点
+        ASTNode* intern(ASTNode* node) { return exprPool ? exprPool->intern(node) : node; }
+        struct ParseError {}; // 由error抛出，在语句列表和顶层声明列表处捕获并恢复
+        [[noreturn]] void error(const std::string& msg);
+        void report(const std::string& msg); // 只记录诊断，不中断解析
+        void synchronize(int start, bool topLevel);
+        bool nextExternalDecl(ASTNode*& decl);
+        // 记录节点覆盖的Token区间：从first到当前位置之前
+        ASTNode* span(ASTNode* node, int first) const {
+            node->firstToken = tokenBase + first;
+            node->lastToken = tokenBase + pos - 1;
+            return node;
+        }
+        // 回溯到to，剖析时把丢弃的Token计入当前规则
+        void rewind(int to) {
+            if (profile && to < pos) profile->rewind(pos - to);
+            pos = to;
+        }
+        // 记录只覆盖单个Token的节点
+        ASTNode* spanAt(ASTNode* node, int index) const {
+            node->firstToken = node->lastToken = tokenBase + index;
+            return node;
+        }
 
         // 顶层结构
         ASTNode* parseProgram();
         ASTNode* parseExternalDeclList();
         ASTNode* parseExternalDecl();
 
+        // 并行解析
+        std::vector<std::pair<int, int>> splitTopLevel() const;
+        std::vector<ASTNode*> parseRange(int begin, int end, std::vector<Diagnostic>& diags);
+        void parseRanges(const std::vector<std::pair<int, int>>& ranges, std::vector<std::vector<ASTNode*>>& results,
+                         std::vector<std::vector<Diagnostic>>& rangeDiags);
+        ASTNode* parseProgramParallel();
+
+        // 增量解析
+        struct TopLevelEntry {
+            int begin;                           // Token下标区间 [begin, end)
+            int end;
+            uint64_t hash;                       // 区间内Token种类和文本的哈希，不含位置
+            std::vector<ASTNode*> decls;         // 该区间解析出的顶层节点
+            std::vector<Diagnostic> diagnostics; // 该区间内的语法错误
+        };
+        std::string source;                  // parseSource/reparse所分析的源码
+        std::vector<TopLevelEntry> topLevel; // 各顶层声明段，按源码顺序
+        bool incremental = false;            // 由parseSource解析，可以reparse
+        ASTNode* assembleTopLevel();
+
+        // 函数体延迟解析
+        int matchBrace(int open) const;
+        void expandBody(ASTNode* node);
+
         // 变量声明
         ASTNode* parseVarDecl();
         ASTNode* parseLocalVarDecl();
@@ -62,6 +199,7 @@ namespace parser {
         ASTNode* parseContinueStmt();
 
         // 表达式相关
+        ASTNode* chainNode(NodeType type, ASTNode* left, const std::string& op, ASTNode* right, int start);
         ASTNode* parseExpr();
         ASTNode* parseAssignExpr();
         ASTNode* parseLogicalOrExpr();
@@ -0,0 +1,66 @@
+#include "ast.h"
+#include "parser.h"
+#include <utility>
+#include <vector>
+
+namespace parser {
+    bool TopLevelReader::next(std::vector<lexer::Token>& chunk) {
+        chunk.clear();
+        while (!done) {
+            lexer::Token token = source.next();
+            auto kind = token.kind;
+            // 词法错误与tokenize一致，作为最后一个Token交给解析器报错
+            done = kind == lexer::TokenKind::EOF_TOKEN || kind == lexer::TokenKind::ERROR_TOKEN;
+            if (kind != lexer::TokenKind::EOF_TOKEN) chunk.push_back(std::move(token));
+            if (!chunk.empty() && (done || splitter.feed(kind))) break;
+        }
+        begin = count;
+        count += (int)chunk.size();
+        return !chunk.empty();
+    }
+
+    // 用子解析器解析一段完整的顶层声明，诊断就地输出后并入本解析器
+    size_t Parser::parseChunk(std::vector<lexer::Token> chunk, int base, const std::function<void(ASTNode*)>& sink) {
+        if (chunk.empty()) return 0;
+        const auto& tail = chunk.back();
+        chunk.push_back(lexer::Token{lexer::TokenKind::EOF_TOKEN, "", tail.line, tail.column});
+        Parser sub(std::move(chunk), debug);
+        sub.tokenBase = base;
+        sub.flatChains = flatChains;
+        sub.profile = profile;
+        // 节点只在本段内共享；sink可能留着声明，解析完后由本解析器的池接管共享节点，同parseRange
+        if (hashCons) {
+            if (!exprPool) exprPool.reset(new ExprPool);
+            sub.exprPool.reset(new ExprPool);
+        }
+        size_t declCount = 0;
+        ASTNode* decl = nullptr;
+        while (sub.nextExternalDecl(decl)) {
+            if (decl) {
+                ++declCount;
+                sink(decl);
+            }
+        }
+        if (sub.exprPool) exprPool->adopt(*sub.exprPool);
+        sub.printDiagnostics();
+        for (auto& diag : sub.diagnostics) diagnostics.push_back(std::move(diag));
+        return declCount;
+    }
+
+    // 按顶层声明边界攒Token，每凑齐一段就用子解析器解析，解析出的声明交给sink后连同Token一起丢弃
+    void Parser::parseStream(lexer::Lexer& source, const std::function<void(ASTNode*)>& sink) {
+        debugLog("parseStream", pos);
+        TopLevelReader reader(source);
+        std::vector<lexer::Token> chunk;
+        size_t declCount = 0;
+        while (reader.next(chunk)) {
+            declCount += parseChunk(std::move(chunk), reader.chunkBegin(), sink);
+        }
+        pos = reader.consumed();
+        debugLog("parseStream_exit", pos);
+        if (declCount == 0 && diagnostics.empty()) {
+            report("program: expected at least one external declaration");
+            printDiagnostics();
+        }
+    }
+}
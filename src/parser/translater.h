@@ -1,15 +1,17 @@
-#ifndef TRANSLATER_H
-#define TRANSLATER_H
+#ifndef AST_TRANSLATER_H
+#define AST_TRANSLATER_H
 #include "ast.h"
 
 namespace parser {
     static const std::unordered_map<NodeType, std::string> nodeTypeToString = {
+        {Unknown, "Unknown"},
         {Program, "Program"},
         {ExternalDeclList, "ExternalDeclList"},
         {FunctionDef, "FunctionDef"},
         {FunctionDecl, "FunctionDecl"},
         {VarDecl, "VarDecl"},
         {LocalVarDecl, "LocalVarDecl"},
+        {VarDeclList, "VarDeclList"},
         {ParamList, "ParamList"},
         {Param, "Param"},
         {CompoundStmt, "CompoundStmt"},
@@ -21,6 +23,7 @@ namespace parser {
         {ReturnStmt, "ReturnStmt"},
         {BreakStmt, "BreakStmt"},
         {ContinueStmt, "ContinueStmt"},
+        {Expr, "Expr"},
         {AssignExpr, "AssignExpr"},
         {LogicalOrExpr, "LogicalOrExpr"},
         {LogicalAndExpr, "LogicalAndExpr"},
@@ -35,29 +38,36 @@ namespace parser {
         {TypeSpec, "TypeSpec"},
         {ArrayType, "ArrayType"},
         {ArrayAccess, "ArrayAccess"},
+        {ParenthesizedExpr, "ParenthesizedExpr"},
         {Identifier, "Identifier"},
         {LongConst, "LongConst"},
         {IntConst, "IntConst"},
         {FloatConst, "FloatConst"},
         {CharConst, "CharConst"},
-        {StringConst, "StringConst"}
+        {StringConst, "StringConst"},
+        {LineComment, "LineComment"},
+        {BlockComment, "BlockComment"},
+        {LazyBody, "LazyBody"}
     };
 
-    inline std::string getNodeTypeString(NodeType type) {
+    inline const std::string& getNodeTypeString(NodeType type) {
+        static const std::string unknown = "Unknown";
         auto it = nodeTypeToString.find(type);
         if (it != nodeTypeToString.end()) {
             return it->second;
         }
-        return "Unknown";
+        return unknown;
     }
 
     static const std::unordered_map<NodeType, std::string> nodeTypeToCNString = {
+        {Unknown, "未知节点"},
         {Program, "程序"},
         {ExternalDeclList, "外部声明列表"},
         {FunctionDef, "函数定义"},
         {FunctionDecl, "函数声明"},
         {VarDecl, "变量声明"},
         {LocalVarDecl, "局部变量声明"},
+        {VarDeclList, "局部变量声明列表"},
         {ParamList, "参数列表"},
         {Param, "参数"},
         {CompoundStmt, "复合语句"},
@@ -69,6 +79,7 @@ namespace parser {
         {ReturnStmt, "return语句"},
         {BreakStmt, "break语句"},
         {ContinueStmt, "continue语句"},
+        {Expr, "表达式"},
         {AssignExpr, "赋值表达式"},
         {LogicalOrExpr, "逻辑或表达式"},
         {LogicalAndExpr, "逻辑与表达式"},
@@ -83,21 +94,26 @@ namespace parser {
         {TypeSpec, "类型说明符"},
         {ArrayType, "数组类型"},
         {ArrayAccess, "数组访问"},
+        {ParenthesizedExpr, "括号表达式"},
         {Identifier, "标识符"},
         {LongConst, "长整型常量"},
         {IntConst, "整型常量"},
         {FloatConst, "浮点型常量"},
         {CharConst, "字符型常量"},
-        {StringConst, "字符串常量"}
+        {StringConst, "字符串常量"},
+        {LineComment, "行注释"},
+        {BlockComment, "块注释"},
+        {LazyBody, "未解析函数体"}
     };
 
-    inline std::string getNodeTypeCNString(NodeType type) {
+    inline const std::string& getNodeTypeCNString(NodeType type) {
+        static const std::string unknown = "未知节点";
         auto it = nodeTypeToCNString.find(type);
         if (it != nodeTypeToCNString.end()) {
             return it->second;
         }
-        return "未知节点";
+        return unknown;
     }
 }
 
-#endif //TRANSLATER_H
+#endif //AST_TRANSLATER_H
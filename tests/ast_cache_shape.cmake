@@ -0,0 +1,26 @@
+# 同一缓存先由默认解析写入，再以 --flat-chains 使用：不得加载形状不同的AST，
+# 输出须与不用缓存的 --flat-chains 解析相同
+# 参数：FORMATTER 可执行文件，INPUT 输入源码
+set(cache ${CMAKE_CURRENT_BINARY_DIR}/shape.cache)
+file(REMOVE ${cache})
+
+function(parse out)
+    execute_process(COMMAND ${FORMATTER} -f ${INPUT} -p ${ARGN} -o ${out} RESULT_VARIABLE rc OUTPUT_QUIET)
+    if (NOT rc EQUAL 0)
+        message(FATAL_ERROR "parse ${ARGN} failed: ${rc}")
+    endif ()
+endfunction()
+
+parse(binary.txt --ast-cache ${cache})
+parse(cached.txt --ast-cache ${cache} --flat-chains)
+parse(fresh.txt --flat-chains)
+
+file(READ binary.txt binary)
+file(READ cached.txt cached)
+file(READ fresh.txt fresh)
+if (binary STREQUAL fresh)
+    message(FATAL_ERROR "${INPUT} has no operator chain, the test checks nothing")
+endif ()
+if (NOT cached STREQUAL fresh)
+    message(FATAL_ERROR "--flat-chains loaded the binary-tree AST from ${cache}")
+endif ()
@@ -0,0 +1,21 @@
+int a[3;
+int ok = 1;
+int f(int x)
+{
+    if (x > 1 return 1;
+    while (x < ) x = 1;
+    for (x = 0; x < 3; x = x + 1 x = 2;
+    return g(x, ;
+    return (x + 1;
+    return a[x;
+    x = y || ;
+    x = y * ;
+    x = - ;
+    if (x) x = 1; else
+}
+float h(;
+int k(int b)
+{
+    int q = 1
+    return b * 2;
+}
@@ -0,0 +1,49 @@
+// 压力测试与缓存测试共用的输入
+int limit = 10;
+float scale = 1.5;
+int table[4][8];
+
+int sum(int values[], int n);
+
+/* 求和 */
+int sum(int values[], int n)
+{
+    int total = 0;
+    int i;
+    for (i = 0; i < n; i = i + 1)
+    {
+        total = total + values[i] * 2 - 1 + i % 3;
+    }
+    return total;
+}
+
+int pick(int a, int b, int c)
+{
+    if (a > b && b > c || a == c)
+    {
+        return a + b + c + a * b * c;
+    }
+    else if (!(a != b))
+    {
+        return -a;
+    }
+    while (a < limit)
+    {
+        a = a + 1;
+        if (a == 5) break;
+        if (a == 3) continue;
+    }
+    return sum(table[a], b) + pick(a - 1, b, c);
+}
+
+void noop()
+{
+    ;
+}
+
+int main()
+{
+    int x = pick(1, 2, 3);
+    noop();
+    return x + x + x + x;
+}
@@ -0,0 +1,81 @@
+// 哈希共享下共享节点的Token区间：串行解析时整个文件共用一个池，共享节点的区间是全文件第一次出现处；
+// 多线程解析时各顶层声明段各用一个池，接管时不跨段去重，每个声明引用的共享节点的区间都落在本声明之内
+#include "expr_pool.h"
+#include "parser.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    bool slurp(const std::string& filename, std::string& data) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) return false;
+        std::stringstream ss;
+        ss << in.rdbuf();
+        data = ss.str();
+        return true;
+    }
+
+    void expect(bool ok, const std::string& what) {
+        if (ok) return;
+        fprintf(stderr, "FAILED: %s\n", what.c_str());
+        failures++;
+    }
+
+    // 统计decl中区间不在decl之内的共享节点；叶子节点的区间须指向同样文本的Token
+    void visit(const parser::ASTNode* node, const parser::ASTNode* decl, const std::vector<lexer::Token>& tokens,
+               size_t& outside) {
+        if (!node) return;
+        if (node->shared) {
+            if (node->firstToken < decl->firstToken || node->lastToken > decl->lastToken) outside++;
+            if (node->children.empty() && !node->token.empty()) {
+                bool valid = node->firstToken >= 0 && node->firstToken < (int)tokens.size() &&
+                             tokens[node->firstToken].text == node->token;
+                expect(valid, "shared leaf '" + node->token + "' points at a token with the same text");
+            }
+        }
+        for (auto* child : node->children) visit(child, decl, tokens, outside);
+    }
+
+    // 按jobs哈希共享地解析source，返回区间落在所属声明之外的共享节点数
+    size_t sharedOutsideDecl(const std::string& source, unsigned jobs, size_t& poolSize) {
+        lexer::Lexer lexer(source.data(), source.size());
+        parser::Parser parser(lexer);
+        parser.jobs = jobs;
+        parser.hashCons = true;
+        auto* root = parser.parse();
+        expect(parser.diagnostics.empty(), "the sample parses without errors");
+        size_t outside = 0;
+        for (auto* decl : root->children[0]->children) visit(decl, decl, parser.tokenList(), outside);
+        poolSize = parser.expressionPool()->size();
+        return outside;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s sample.c\n", argv[0]);
+        return 2;
+    }
+    std::string source;
+    if (!slurp(argv[1], source)) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 2;
+    }
+    size_t serialPool = 0;
+    size_t parallelPool = 0;
+    // 串行时后面的声明复用前面声明中的节点，否则这个输入检查不到跨段的情况
+    expect(sharedOutsideDecl(source, 1, serialPool) > 0, "serial parse shares nodes across declarations");
+    expect(sharedOutsideDecl(source, 4, parallelPool) == 0, "-j keeps every shared node inside its declaration");
+    expect(parallelPool > serialPool, "-j does not merge duplicates across declarations");
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("shared node spans follow the per-range pools under -j\n");
+    return 0;
+}
@@ -0,0 +1,164 @@
+// 增量重解析测试：对样例源码做一系列编辑，每次编辑后增量重解析得到的Token、诊断和带源码位置的AST导出
+// 都须与直接解析编辑后源码的结果相同；编辑以外的顶层声明须按指针复用
+#include "parser.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    bool slurp(const std::string& filename, std::string& data) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) return false;
+        std::stringstream ss;
+        ss << in.rdbuf();
+        data = ss.str();
+        return true;
+    }
+
+    void expect(bool ok, const std::string& what) {
+        if (ok) return;
+        fprintf(stderr, "FAILED: %s\n", what.c_str());
+        failures++;
+    }
+
+    // 一次解析中可比较的全部结果
+    std::string snapshot(parser::Parser& parser) {
+        std::ostringstream out;
+        for (const auto& tk : parser.tokenList()) {
+            out << static_cast<int>(tk.kind) << ' ' << tk.text << ' ' << tk.line << ':' << tk.column << '@'
+                << tk.offset << '\n';
+        }
+        for (const auto& diag : parser.diagnostics) out << "diag " << diag.token << ' ' << diag.message << '\n';
+        std::string path = "incremental_parse.json";
+        std::string ast;
+        parser.exportAST(path, "json");
+        slurp(path, ast);
+        return out.str() + ast;
+    }
+
+    // 按edit增量重解析，与直接解析编辑后的text比较
+    void reparseAndCompare(parser::Parser& parser, std::string& text, const parser::SourceEdit& edit,
+                           const std::string& what) {
+        text.replace(edit.offset, edit.removed, edit.inserted);
+        parser.reparse(edit);
+        parser::Parser fresh(std::vector<lexer::Token>{});
+        fresh.parseSource(text);
+        expect(snapshot(parser) == snapshot(fresh), what + ": differs from a fresh parse");
+    }
+
+    std::vector<parser::ASTNode*> decls(parser::Parser& parser) {
+        return parser.parse()->children[0]->children;
+    }
+
+    // 把text中第一处from换成to的编辑
+    parser::SourceEdit replaceFirst(const std::string& text, const std::string& from, const std::string& to) {
+        size_t at = text.find(from);
+        if (at == std::string::npos) {
+            fprintf(stderr, "test input has no \"%s\"\n", from.c_str());
+            exit(2);
+        }
+        return parser::SourceEdit{at, from.size(), to};
+    }
+
+    // 只改动一个函数体：只重解析这一段，其余声明的子树不变
+    void editOneFunction(const std::string& input) {
+        std::string text = input;
+        parser::Parser parser(std::vector<lexer::Token>{});
+        parser.parseSource(text);
+        auto before = decls(parser);
+        reparseAndCompare(parser, text, replaceFirst(text, "int total = 0;", "int total = 40 + 2;"), "edit in a body");
+        auto after = decls(parser);
+        const auto& stats = parser.lastReparse;
+        expect(stats.reparsedRanges == 1, "edit in a body: exactly one range is reparsed");
+        expect(stats.relexedBytes * 4 < text.size(), "edit in a body: only the edited function is re-lexed");
+        size_t kept = 0;
+        for (auto* decl : after) {
+            for (auto* old : before) kept += decl == old;
+        }
+        expect(after.size() == before.size() && kept == before.size() - 1,
+               "edit in a body: every other declaration keeps its subtree");
+    }
+
+    // 在两个声明之间插入一个函数：新函数之外的声明都按内容哈希或对齐复用
+    void insertFunction(const std::string& input) {
+        std::string text = input;
+        parser::Parser parser(std::vector<lexer::Token>{});
+        parser.parseSource(text);
+        auto before = decls(parser);
+        size_t at = text.find("int pick(");
+        reparseAndCompare(parser, text, parser::SourceEdit{at, 0, "int added(int v)\n{\n    return v + 1;\n}\n\n"},
+                          "insert a function");
+        expect(parser.lastReparse.reparsedRanges == 1, "insert a function: only the new function is parsed");
+        expect(decls(parser).size() == before.size() + 1, "insert a function: one more declaration");
+    }
+
+    // 有语法错误的段内的编辑：诊断随之更新，其余段的诊断平移后保留
+    void editErroneousRange(const std::string& input) {
+        std::string text = input;
+        parser::Parser parser(std::vector<lexer::Token>{});
+        parser.parseSource(text);
+        size_t errors = parser.diagnostics.size();
+        expect(errors > 2, "errors.c has several diagnostics");
+        // 修好一处错误，同一函数里的其余错误仍在
+        reparseAndCompare(parser, text, replaceFirst(text, "while (x < )", "while (x < 2)"), "fix one error");
+        expect(parser.diagnostics.size() == errors - 1, "fix one error: one diagnostic less");
+        expect(parser.lastReparse.reparsedRanges == 1, "fix one error: only the erroneous function is reparsed");
+        // 在出错的段内再引入一处错误，并改变Token数，之后各段的诊断须平移
+        reparseAndCompare(parser, text, replaceFirst(text, "x = - ;", "x = - - ( ;"), "add an error");
+        // 删掉函数末尾的 '}'，该段与后面的段合并
+        reparseAndCompare(parser, text, replaceFirst(text, "else\n}", "else\n"), "merge ranges");
+        reparseAndCompare(parser, text, replaceFirst(text, "else\n", "else\n}"), "split ranges");
+    }
+
+    // 伪随机的插入、删除和替换，覆盖未闭合的注释和字符串、括号失衡、词法错误等情况
+    void randomEdits(const std::string& input, unsigned steps) {
+        static const char* snippets[] = {"x", ";", "}", "{", "/*", "*/", "int ", "\n", "1 + ", "\"", "// c\n",
+                                         "(", ")", "@", "float f(int a) { return a; }\n", "  "};
+        const size_t snippetCount = sizeof(snippets) / sizeof(snippets[0]);
+        std::string text = input;
+        parser::Parser parser(std::vector<lexer::Token>{});
+        parser.parseSource(text);
+        uint64_t state = 12345;
+        auto next = [&state](size_t bound) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return bound ? static_cast<size_t>(state >> 33) % bound : 0;
+        };
+        for (unsigned i = 0; i < steps; ++i) {
+            size_t offset = next(text.size() + 1);
+            size_t removed = next(3) == 0 ? std::min(next(8), text.size() - offset) : 0;
+            std::string inserted = next(4) == 0 ? "" : snippets[next(snippetCount)];
+            reparseAndCompare(parser, text, parser::SourceEdit{offset, removed, inserted},
+                              "random edit " + std::to_string(i));
+            if (failures) return;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s sample.c errors.c\n", argv[0]);
+        return 2;
+    }
+    std::string sample;
+    std::string errors;
+    if (!slurp(argv[1], sample) || !slurp(argv[2], errors)) {
+        fprintf(stderr, "cannot read the test inputs\n");
+        return 2;
+    }
+    editOneFunction(sample);
+    insertFunction(sample);
+    editErroneousRange(errors);
+    randomEdits(sample + errors, 300);
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("incremental reparse matches a fresh parse after every edit\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+// 并发压力测试：多个线程同时用各自的Parser和Formatter处理同一批输入，
+// 每次的格式化结果和AST输出都须与串行运行的结果一致
+// 用 -DENABLE_TSAN=ON 构建时由ThreadSanitizer检查数据竞争
+#include "formatter.h"
+#include "parser.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 各种解析选项的组合，轮流使用
+    struct Config {
+        unsigned jobs;
+        bool hashCons;
+        bool flatChains;
+        bool lazyBodies;
+    };
+    const Config configs[] = {
+        {1, false, false, false},
+        {2, false, false, false},
+        {3, true, false, false},
+        {1, true, true, false},
+        {1, false, false, true},
+        {2, true, true, true},
+    };
+    const size_t configCount = sizeof(configs) / sizeof(configs[0]);
+
+    // 一次运行的结果
+    struct Result {
+        std::string formatted;
+        std::string ast;
+    };
+
+    bool slurp(const std::string& filename, std::string& data) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) return false;
+        std::stringstream ss;
+        ss << in.rdbuf();
+        data = ss.str();
+        return true;
+    }
+
+    // 按config格式化input并输出AST，AST先写到scratch再读回
+    bool run(const std::string& input, const Config& config, const std::string& scratch, Result& result) {
+        FILE* file = fopen(input.c_str(), "r");
+        if (!file) return false;
+        formatter::Formatter formatter(file, false, scratch, config.jobs, config.hashCons, config.flatChains);
+        parser::BufferedWriter out;
+        formatter.format(out);
+        result.formatted.assign(out.data(), out.size());
+
+        file = fopen(input.c_str(), "r");
+        if (!file) return false;
+        parser::Parser parser(file, false, scratch);
+        parser.jobs = config.jobs;
+        parser.hashCons = config.hashCons;
+        parser.flatChains = config.flatChains;
+        parser.lazyBodies = config.lazyBodies;
+        parser.parse();
+        parser.expandBodies();
+        std::string astFile = scratch;
+        parser.outputAST(astFile);
+        return slurp(astFile, result.ast);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s input.c...\n", argv[0]);
+        return 2;
+    }
+    std::vector<std::string> inputs(argv + 1, argv + argc);
+    const unsigned threadCount = 8;
+    const unsigned rounds = 12;
+
+    // 串行运行得到参考结果
+    std::vector<Result> expected(inputs.size() * configCount);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (size_t c = 0; c < configCount; ++c) {
+            if (!run(inputs[i], configs[c], "stress_ref.txt", expected[i * configCount + c])) {
+                fprintf(stderr, "cannot read %s\n", inputs[i].c_str());
+                return 1;
+            }
+        }
+    }
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            std::string scratch = "stress_" + std::to_string(t) + ".txt";
+            for (unsigned r = 0; r < rounds; ++r) {
+                size_t i = (t + r) % inputs.size();
+                size_t c = (t * 7 + r) % configCount;
+                Result result;
+                const Result& want = expected[i * configCount + c];
+                if (!run(inputs[i], configs[c], scratch, result) || result.formatted != want.formatted ||
+                    result.ast != want.ast) {
+                    fprintf(stderr, "thread %u: %s with config %zu differs from the serial run\n", t,
+                            inputs[i].c_str(), c);
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    if (failures) {
+        fprintf(stderr, "%d mismatches\n", failures.load());
+        return 1;
+    }
+    printf("%u threads x %u rounds: all results match the serial run\n", threadCount, rounds);
+    return 0;
+}